@@ -14,12 +14,6 @@ struct nrf_wifi_cfg80211_mgmt_registration {
 	u8 match[];
 };
 
-struct cookie_info {
-	struct list_head list;
-	unsigned long long host_cookie;
-	unsigned long long rpu_cookie;
-};
-
 int ap_event_cookie(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx, int event_num,
 		    void *event_info);
 
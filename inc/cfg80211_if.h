@@ -14,6 +14,19 @@
 struct wiphy *cfg80211_if_init(void);
 void cfg80211_if_deinit(struct wiphy *wiphy);
 
+void nrf_wifi_vif_cmd_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+bool nrf_wifi_vif_cmd_rsp_lock(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+			       enum nrf_wifi_vif_cmd cmd);
+void nrf_wifi_vif_cmd_rsp_unlock(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+void nrf_wifi_bss_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+void nrf_wifi_sched_scan_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+void nrf_wifi_sched_scan_deinit(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+void nrf_wifi_cqm_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+void nrf_wifi_cqm_reset(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+void nrf_wifi_cqm_rssi(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx, s32 rssi);
+void
+nrf_wifi_sta_cache_invalidate(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx);
+
 void nrf_wifi_cfg80211_scan_start_callbk_fn(
 	void *os_vif_ctx,
 	struct nrf_wifi_umac_event_trigger_scan *scan_start_event,
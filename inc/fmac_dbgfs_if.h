@@ -30,6 +30,8 @@ void nrf_wifi_wlan_fmac_dbgfs_twt_deinit(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
 int nrf_wifi_wlan_fmac_dbgfs_conf_init(struct dentry *root,
 				       struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
 void nrf_wifi_wlan_fmac_dbgfs_conf_deinit(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
+int nrf_wifi_wlan_fmac_dbgfs_pktram_init(struct dentry *root,
+					 struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
 #ifdef CONFIG_NRF700X_RADIO_TEST
 int nrf_wifi_wlan_fmac_dbgfs_radio_test_init(
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
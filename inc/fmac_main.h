@@ -7,7 +7,12 @@
 #ifndef __FMAC_MAIN_H__
 #define __FMAC_MAIN_H__
 
+#include <linux/average.h>
+#include <linux/hashtable.h>
 #include <net/cfg80211.h>
+#include <net/codel.h>
+#include <net/fq.h>
+#include <net/xdp.h>
 #include "fmac_structs.h"
 #include "sta.h"
 #include "ap.h"
@@ -17,30 +22,200 @@
 #include "driver_linux.h"
 #endif /* RPU_MODE_EXPLORER */
 
+#ifdef CONFIG_NRF700X_DATA_TX
+enum nrf_wifi_tx_flags {
+	NRF_WIFI_TX_NO_CREDITS,
+};
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+/* UMAC requests the cfg80211 ops wait for, see nrf_wifi_vif_cmd_begin() */
+enum nrf_wifi_vif_cmd {
+	NRF_WIFI_VIF_CMD_NONE,
+	NRF_WIFI_VIF_CMD_GET_STATION,
+	NRF_WIFI_VIF_CMD_GET_TX_POWER,
+	NRF_WIFI_VIF_CMD_GET_CHANNEL,
+	NRF_WIFI_VIF_CMD_SET_IF,
+};
+
+/* Buckets of the host side multicast hash filter */
+#define NRF_WIFI_MC_FILTER_BITS 64
+
+/* BSSes tracked per scan to drop repeated beacons and probe responses */
+#define NRF_WIFI_BSS_HASH_BITS 6
+#define NRF_WIFI_BSS_TABLE_SIZE 128
+
+struct nrf_wifi_bss_entry {
+	struct hlist_node node;
+	unsigned char bssid[ETH_ALEN];
+	unsigned int freq;
+	u32 ie_crc;
+	int signal;
+	unsigned long ts;
+};
+
+/* Averaged signal of the received frames, negated as EWMAs are unsigned */
+DECLARE_EWMA(nrf_wifi_rssi, 4, 4)
+
+/* Per-CPU netdev counters, summed up by ndo_get_stats64 */
+struct nrf_wifi_netdev_pcpu_stats {
+	u64 rx_packets;
+	u64 rx_bytes;
+	u64 rx_dropped;
+	u64 rx_multicast;
+	u64 rx_mc_filtered;
+	u64 tx_packets;
+	u64 tx_bytes;
+	u64 tx_dropped;
+	u64 tx_errors;
+	u64 tx_fast_pkts;
+	u64 tx_deferred_pkts;
+	u64 tx_queue_stops;
+	u64 tx_queue_wakes;
+	u64 tx_credit_stalls;
+	u64 tx_stopped_ns;
+	/* Frames going through generic XDP are only told apart as passed or
+	 * consumed, their XDP_TX and XDP_REDIRECT are counted in rx_xdp_drop
+	 */
+	u64 rx_xdp_drop;
+	u64 rx_xdp_tx;
+	u64 rx_xdp_redirect;
+	struct u64_stats_sync syncp;
+};
+
 struct nrf_wifi_fmac_vif_ctx_lnx {
 	struct nrf_wifi_ctx_lnx *rpu_ctx;
 	struct net_device *netdev;
 	struct wireless_dev *wdev;
 	struct cfg80211_bss *bss;
 	struct cfg80211_scan_request *nrf_wifi_scan_req;
+	/* Time from a scan request to reporting its results */
+	ktime_t scan_start;
+	unsigned long long scans;
+	unsigned long long scans_aborted;
+	unsigned int scan_last_us;
+	unsigned int scan_min_us;
+	unsigned int scan_max_us;
+	unsigned long long scan_total_us;
+	/* Host scheduled scan, see nrf_wifi_cfg80211_sched_scan_start() */
+	struct mutex sched_scan_lock;
+	struct cfg80211_sched_scan_request *sched_scan_req;
+	struct delayed_work ws_sched_scan;
+	unsigned int sched_scan_plan;
+	unsigned int sched_scan_iter;
+	/* The scan the RPU runs belongs to the scheduled scan */
+	bool sched_scan_active;
+	bool sched_scan_matched;
+	unsigned long long sched_scans;
+	unsigned long long sched_scan_matches;
+	/* BSSes informed to cfg80211 since the last scan started */
+	spinlock_t bss_lock;
+	DECLARE_HASHTABLE(bss_hash, NRF_WIFI_BSS_HASH_BITS);
+	struct nrf_wifi_bss_entry bss_table[NRF_WIFI_BSS_TABLE_SIZE];
+	unsigned int bss_count;
+	unsigned long long bss_informed;
+	unsigned long long bss_merged;
+	unsigned long long bss_table_full;
+	/* Time from the first authentication frame to carrier on */
+	ktime_t connect_start;
+	bool connect_pending;
+	bool connect_roam;
+	unsigned long long connects;
+	unsigned long long roams;
+	unsigned int connect_last_us;
+	unsigned int connect_min_us;
+	unsigned int connect_max_us;
+	/* Connection quality monitor, see nrf_wifi_cqm_rssi() */
+	spinlock_t cqm_lock;
+	struct ewma_nrf_wifi_rssi cqm_rssi_avg;
+	s32 cqm_rssi_thold;
+	u32 cqm_rssi_hyst;
+	bool cqm_rssi_range;
+	s32 cqm_rssi_low;
+	s32 cqm_rssi_high;
+	/* Signal of the last event, 0 if none since (re)configuring */
+	s32 cqm_rssi_last;
+	unsigned long long cqm_rssi_low_events;
+	unsigned long long cqm_rssi_high_events;
+	/* EDCA parameters programmed per access category, see
+	 * nrf_wifi_cfg80211_set_txq_params()
+	 */
+	struct ieee80211_txq_params wmm_params[NL80211_NUM_ACS];
+	unsigned long wmm_params_set;
 
 	unsigned char if_idx;
 
-	/* event responses */
-	struct nrf_wifi_sta_info *station_info;
-	struct nrf_wifi_chan_definition *chan_def;
+	/* event responses, one request in flight at a time */
+	struct mutex cmd_lock;
+	spinlock_t cmd_rsp_lock;
+	struct completion cmd_done;
+	enum nrf_wifi_vif_cmd cmd;
+	u32 cmd_seq;
+	struct nrf_wifi_sta_info station_info;
+	/* station_info doubles as the get_station cache, see sta_info_ttl_ms */
+	bool sta_cache_valid;
+	/* Bumped by every invalidate, a response only fills the cache if no
+	 * invalidate ran while it was being waited for.
+	 */
+	atomic_t sta_cache_gen;
+	unsigned char sta_cache_mac[ETH_ALEN];
+	unsigned long sta_cache_ts_us;
+	unsigned long long sta_cache_hits;
+	unsigned long long sta_cache_misses;
+	struct nrf_wifi_chan_definition chan_def;
 	int tx_power;
-	int event_tx_power;
-	int event_set_if;
 	int status_set_if;
 	struct p2p_info p2p;
 	unsigned long rssi_record_timestamp_us;
 	signed short rssi;
+	struct napi_struct napi;
+	struct sk_buff_head rx_napi_q;
+	struct bpf_prog __rcu *xdp_prog;
+	/* Multicast address updates waiting to be sent to the UMAC */
+	spinlock_t mc_lock;
+	struct list_head mc_cmds;
+	struct work_struct ws_rx_mode;
+	unsigned long mc_filter[BITS_TO_LONGS(NRF_WIFI_MC_FILTER_BITS)];
+	bool mc_all;
+	unsigned long long mc_add_cmds;
+	unsigned long long mc_del_cmds;
+	struct xdp_rxq_info xdp_rxq;
+	struct nrf_wifi_netdev_pcpu_stats __percpu *stats;
 #ifdef CONFIG_NRF700X_DATA_TX
-	void *data_txq;
+	/* Flow hashed fair queue with CoDel, one tin per access category */
+	struct fq tx_fq;
+	struct fq_tin tx_tin[NL80211_NUM_ACS];
+	struct codel_vars *tx_cvars;
+	struct codel_vars tx_def_cvars[NL80211_NUM_ACS];
+	struct codel_params tx_cparams;
+	struct codel_stats tx_cstats;
+	struct workqueue_struct *tx_wq;
 	struct work_struct ws_data_tx;
-	struct work_struct ws_queue_monitor;
-	unsigned long long num_tx_pkt;
+	u32 tx_id;
+	/* Frames handed to the FMAC and not yet freed on TX done */
+	atomic_t tx_inflight;
+	int tx_credits;
+	int tx_credits_low;
+	/* Per AC fair queue backlog that stops the netdev queue, the
+	 * ethtool TX ring size
+	 */
+	unsigned int tx_qlen;
+	/* Frames handed to the FMAC per TX work run, the ethtool tx-frames */
+	unsigned int tx_budget;
+	unsigned long tx_flags;
+	ktime_t tx_stop_ts[NL80211_NUM_ACS];
+	/* In-flight frames allowed per TX token, scales tx_credits. See
+	 * tx_credit_adaptive.
+	 */
+	unsigned int tx_credit_depth;
+	/* Peak fair queue backlog since the last depth update */
+	unsigned int tx_credit_backlog;
+	unsigned long tx_credit_next;
+#ifdef DEBUG_MODE_SUPPORT
+	/* FMAC TX coalesce histogram at the last depth update */
+	unsigned int tx_coalesce_seen[CONFIG_NRF700X_MAX_TX_AGGREGATION];
+#endif /* DEBUG_MODE_SUPPORT */
+	unsigned long long tx_credit_raises;
+	unsigned long long tx_credit_lowers;
 #endif
 };
 
@@ -8,6 +8,7 @@
 #define __MAIN_H__
 
 #include <linux/debugfs.h>
+#include <linux/hashtable.h>
 #include "rpu_if.h"
 #ifdef DEBUG_MODE_SUPPORT
 #include "host_rpu_umac_if.h"
@@ -18,6 +19,9 @@
 
 #define NRF_WIFI_FMAC_DRV_VER "1.0.0.0"
 
+/* 3 bytes for addreess, 3 bytes for length */
+#define MAX_PKT_RAM_TX_ALIGN_OVERHEAD 6
+
 enum connect_status {
 	DISCONNECTED,
 	CONNECTED,
@@ -47,6 +51,80 @@ struct rpu_twt_params {
 	int teardown_event_cnt;
 };
 
+#ifndef CONFIG_NRF700X_RADIO_TEST
+enum nrf_wifi_pktram_policy {
+	NRF_WIFI_PKTRAM_POLICY_STATIC,
+	NRF_WIFI_PKTRAM_POLICY_RX,
+	NRF_WIFI_PKTRAM_POLICY_TX,
+	NRF_WIFI_PKTRAM_POLICY_AUTO,
+	NRF_WIFI_PKTRAM_POLICY_MAX,
+};
+
+enum nrf_wifi_pktram_dir {
+	NRF_WIFI_PKTRAM_DIR_NONE,
+	NRF_WIFI_PKTRAM_DIR_RX,
+	NRF_WIFI_PKTRAM_DIR_TX,
+};
+
+/**
+ * struct nrf_wifi_pktram - State of the advisory PKTRAM split recommender.
+ * @ws: Periodic evaluation of the traffic direction.
+ * @rx_bytes: Bytes received by the default interface at the last run.
+ * @tx_bytes: Bytes sent by the default interface at the last run.
+ * @dir: Direction of the last busy interval.
+ * @hold: Consecutive busy intervals seen in @dir.
+ * @pending: The policy recommends a split other than the one in use.
+ */
+struct nrf_wifi_pktram {
+	struct delayed_work ws;
+	unsigned long long rx_bytes;
+	unsigned long long tx_bytes;
+	enum nrf_wifi_pktram_dir dir;
+	unsigned int hold;
+	bool pending;
+};
+
+#define NRF_WIFI_COOKIE_HASH_BITS 4
+#define NRF_WIFI_COOKIE_SLAB_SIZE 32
+
+struct cookie_info {
+	struct hlist_node node;
+	struct list_head list;
+	unsigned long ts;
+	unsigned long long host_cookie;
+	unsigned long long rpu_cookie;
+};
+
+/**
+ * struct nrf_wifi_cookies - RPU cookies of management frames and remain on
+ *	channel requests, mapped to the ones given to cfg80211.
+ * @lock: Protects all of the below.
+ * @hash: Entries in use keyed by RPU cookie.
+ * @used: Entries in use, oldest first.
+ * @free: Entries of @slab not in use.
+ * @slab: Backing storage, the RPU answers a handful of cookies at a time.
+ * @count: Entries in use.
+ * @adds: Cookies added.
+ * @hits: Lookups finding their cookie.
+ * @misses: Lookups not finding their cookie.
+ * @expired: Entries the RPU never reported on, dropped once stale.
+ * @recycled: Entries dropped before expiring to make room for a new one.
+ */
+struct nrf_wifi_cookies {
+	spinlock_t lock;
+	DECLARE_HASHTABLE(hash, NRF_WIFI_COOKIE_HASH_BITS);
+	struct list_head used;
+	struct list_head free;
+	struct cookie_info slab[NRF_WIFI_COOKIE_SLAB_SIZE];
+	unsigned int count;
+	unsigned long long adds;
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long expired;
+	unsigned long long recycled;
+};
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
+
 struct nrf_wifi_ctx_lnx {
 	void *rpu_ctx;
 	struct nrf_wifi_fmac_vif_ctx_lnx *def_vif_ctx;
@@ -66,16 +144,45 @@ struct nrf_wifi_ctx_lnx {
 	struct nrf_wifi_umac_set_beacon_info info;
 	struct rpu_btcoex btcoex;
 #endif
-	struct list_head cookie_list;
 	struct dentry *dbgfs_nrf_wifi_twt_root;
 	struct rpu_twt_params twt_params;
+#ifndef CONFIG_NRF700X_RADIO_TEST
+	struct nrf_wifi_pktram pktram;
+	struct nrf_wifi_cookies cookies;
+	/* RPU wide rate settings, see nrf_wifi_cfg80211_set_bitrate_mask() */
+	bool tx_rate_fixed;
+	unsigned char tx_rate_flag;
+	int tx_rate;
+	bool he_ltf_gi_fixed;
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
 };
 
+#ifndef CONFIG_NRF700X_RADIO_TEST
+/**
+ * struct nrf_wifi_rx_pool_stats - Host view of one RX buffer pool.
+ * @posted: Buffers handed to the RPU at the last sample.
+ * @min_posted: Lowest @posted seen since the pools were programmed.
+ * @starved: Samples which found no buffer handed to the RPU.
+ * @samples: Number of samples taken, one per NAPI poll receiving frames.
+ */
+struct nrf_wifi_rx_pool_stats {
+	unsigned int posted;
+	unsigned int min_posted;
+	unsigned long long starved;
+	unsigned long long samples;
+};
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
+
 struct nrf_wifi_drv_priv_lnx {
 	struct dentry *dbgfs_root;
 	struct dentry *dbgfs_ver_root;
 	struct nrf_wifi_fmac_priv *fmac_priv;
 	bool drv_init;
+#ifndef CONFIG_NRF700X_RADIO_TEST
+	/* RX pools the FMAC was initialised with */
+	struct rx_buf_pool_params rx_pools[MAX_NUM_OF_RX_QUEUES];
+	struct nrf_wifi_rx_pool_stats rx_pool_stats[MAX_NUM_OF_RX_QUEUES];
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
 };
 
 struct nrf_wifi_ctx_lnx *nrf_wifi_fmac_dev_add_lnx(void);
@@ -83,4 +190,25 @@ void nrf_wifi_fmac_dev_rem_lnx(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
 enum nrf_wifi_status
 nrf_wifi_fmac_dev_init_lnx(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
 void nrf_wifi_fmac_dev_deinit_lnx(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
+#ifndef CONFIG_NRF700X_RADIO_TEST
+void nrf_wifi_rx_pools_get(struct rx_buf_pool_params *pools);
+void nrf_wifi_rx_pools_sample(struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx);
+
+unsigned int nrf_wifi_rx_pools_size(const struct rx_buf_pool_params *pools);
+void nrf_wifi_pktram_init(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
+void nrf_wifi_pktram_start(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
+void nrf_wifi_pktram_stop(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
+enum nrf_wifi_pktram_dir
+nrf_wifi_pktram_target_dir(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx);
+bool nrf_wifi_pktram_target(enum nrf_wifi_pktram_dir dir,
+			    struct rx_buf_pool_params *pools);
+
+void nrf_wifi_cookies_init(struct nrf_wifi_cookies *cookies);
+void nrf_wifi_cookie_add(struct nrf_wifi_cookies *cookies,
+			 unsigned long long host_cookie,
+			 unsigned long long rpu_cookie);
+bool nrf_wifi_cookie_get(struct nrf_wifi_cookies *cookies,
+			 unsigned long long rpu_cookie,
+			 unsigned long long *host_cookie, bool remove);
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
 #endif /* __MAIN_H__ */
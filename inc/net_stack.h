@@ -11,6 +11,7 @@
 #include "fmac_main.h"
 
 #ifndef CONFIG_NRF700X_RADIO_TEST
+extern const struct ethtool_ops nrf_wifi_ethtool_ops;
 
 struct nrf_wifi_fmac_vif_ctx_lnx *
 nrf_wifi_netdev_add_vif(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx,
@@ -19,9 +20,16 @@ nrf_wifi_netdev_add_vif(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx,
 
 void nrf_wifi_netdev_del_vif(struct net_device *netdev);
 
+void nrf_wifi_netdev_stats_read(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+				struct nrf_wifi_netdev_pcpu_stats *sum);
+
 void nrf_wifi_netdev_frame_rx_callbk_fn(void *vif_ctx, void *frm);
 
 enum nrf_wifi_status nrf_wifi_netdev_if_state_chg_callbk_fn(
 	void *vif_ctx, enum nrf_wifi_fmac_if_carr_state if_state);
+
+#ifdef CONFIG_NRF700X_DATA_TX
+bool nrf_wifi_netdev_tx_done(struct sk_buff *skb);
+#endif /* CONFIG_NRF700X_DATA_TX */
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
 #endif /* __NET_STACK_H__ */
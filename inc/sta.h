@@ -21,6 +21,13 @@ int nrf_wifi_cfg80211_set_power_mgmt(struct wiphy *wiphy,
 int nrf_wifi_cfg80211_scan(struct wiphy *wiphy,
 			   struct cfg80211_scan_request *req);
 
+int nrf_wifi_cfg80211_sched_scan_start(struct wiphy *wiphy,
+				       struct net_device *dev,
+				       struct cfg80211_sched_scan_request *req);
+
+int nrf_wifi_cfg80211_sched_scan_stop(struct wiphy *wiphy,
+				      struct net_device *dev, u64 reqid);
+
 int nrf_wifi_cfg80211_auth(struct wiphy *wiphy, struct net_device *netdev,
 			   struct cfg80211_auth_request *req);
 
@@ -59,4 +66,16 @@ int nrf_wifi_cfg80211_get_channel(struct wiphy *wiphy,
 
 int nrf_wifi_cfg80211_set_wiphy_params(struct wiphy *wiphy,
 				       unsigned int changed);
+
+int nrf_wifi_cfg80211_set_cqm_rssi_config(struct wiphy *wiphy,
+					  struct net_device *dev,
+					  s32 rssi_thold, u32 rssi_hyst);
+
+int nrf_wifi_cfg80211_set_cqm_rssi_range(struct wiphy *wiphy,
+					 struct net_device *dev,
+					 s32 rssi_low, s32 rssi_high);
+
+int nrf_wifi_cfg80211_set_bitrate_mask(
+	struct wiphy *wiphy, struct net_device *netdev, const u8 *peer,
+	const struct cfg80211_bitrate_mask *mask);
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
@@ -4,18 +4,126 @@
  * SPDX-License-Identifier: GPL-2.0
  */
 
+#include <linux/crc32.h>
+
 #include "host_rpu_umac_if.h"
 #include "main.h"
 #include "fmac_main.h"
 #include "net_stack.h"
 #include "fmac_api.h"
+#include "cfg80211_if.h"
 
 extern const struct ieee80211_txrx_stypes ieee80211_default_mgmt_stypes[];
 extern struct ieee80211_supported_band band_2ghz;
 extern struct ieee80211_supported_band band_5ghz;
+extern unsigned int sta_info_ttl_ms;
 int get_scan_results;
 unsigned long long cmd_frame_cookie_g;
 
+/* Signal change, in mBm, worth telling cfg80211 about */
+#define NRF_WIFI_BSS_SIGNAL_DELTA 500
+/* Unchanged BSSes are informed again well before cfg80211 expires them */
+#define NRF_WIFI_BSS_REFRESH_MS 10000
+
+/* Limits of the host scheduled scan */
+#define NRF_WIFI_SCHED_SCAN_MAX_MATCH_SETS 16
+#define NRF_WIFI_SCHED_SCAN_MAX_PLANS 4
+#define NRF_WIFI_SCHED_SCAN_MAX_PLAN_INTERVAL 3600
+#define NRF_WIFI_SCHED_SCAN_MAX_PLAN_ITERATIONS 100
+
+/* Data rate handing the TX rate back to the RPU rate control */
+#define NRF_WIFI_TX_RATE_AUTO -1
+/* HE GI and LTF of a bitrate mask which does not set them */
+#define NRF_WIFI_HE_LTF_GI_UNSET 0xFF
+
+/* Response timeouts of the synchronous UMAC requests */
+#define NRF_WIFI_VIF_CMD_TIMEOUT_MS 5000
+#define NRF_WIFI_VIF_CHG_TIMEOUT_MS 50000
+
+void nrf_wifi_vif_cmd_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	mutex_init(&vif_ctx_lnx->cmd_lock);
+	spin_lock_init(&vif_ctx_lnx->cmd_rsp_lock);
+	init_completion(&vif_ctx_lnx->cmd_done);
+	vif_ctx_lnx->cmd = NRF_WIFI_VIF_CMD_NONE;
+}
+
+/* Serialises the requests on a vif, the response event of @cmd fills in the
+ * vif buffers and wakes up nrf_wifi_vif_cmd_wait()
+ */
+static void
+nrf_wifi_vif_cmd_begin(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+		       enum nrf_wifi_vif_cmd cmd)
+{
+	mutex_lock(&vif_ctx_lnx->cmd_lock);
+
+	spin_lock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+	reinit_completion(&vif_ctx_lnx->cmd_done);
+	vif_ctx_lnx->cmd = cmd;
+	vif_ctx_lnx->cmd_seq++;
+	spin_unlock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+}
+
+static int nrf_wifi_vif_cmd_wait(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+				 unsigned int timeout_ms)
+{
+	int status = 0;
+
+	if (wait_for_completion_timeout(&vif_ctx_lnx->cmd_done,
+					msecs_to_jiffies(timeout_ms)))
+		return 0;
+
+	/* A response racing the timeout still counts, later ones are dropped */
+	spin_lock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+	if (!completion_done(&vif_ctx_lnx->cmd_done)) {
+		pr_err("%s: Timed out waiting for response %d (seq %u)\n",
+		       __func__, vif_ctx_lnx->cmd, vif_ctx_lnx->cmd_seq);
+		vif_ctx_lnx->cmd = NRF_WIFI_VIF_CMD_NONE;
+		status = -ETIMEDOUT;
+	}
+	spin_unlock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+
+	return status;
+}
+
+static void nrf_wifi_vif_cmd_end(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	spin_lock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+	vif_ctx_lnx->cmd = NRF_WIFI_VIF_CMD_NONE;
+	spin_unlock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+
+	mutex_unlock(&vif_ctx_lnx->cmd_lock);
+}
+
+/* Called from the event callbacks, returns with the response lock held if
+ * @cmd is the request being waited for. The callback then copies the
+ * response and calls nrf_wifi_vif_cmd_rsp_unlock().
+ */
+bool nrf_wifi_vif_cmd_rsp_lock(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+			       enum nrf_wifi_vif_cmd cmd)
+{
+	spin_lock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+
+	if (vif_ctx_lnx->cmd == cmd)
+		return true;
+
+	pr_debug("%s: Dropping unexpected response %d (seq %u)\n", __func__,
+		 cmd, vif_ctx_lnx->cmd_seq);
+
+	spin_unlock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+
+	return false;
+}
+
+void nrf_wifi_vif_cmd_rsp_unlock(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	/* Only the first response completes the request */
+	vif_ctx_lnx->cmd = NRF_WIFI_VIF_CMD_NONE;
+	complete(&vif_ctx_lnx->cmd_done);
+
+	spin_unlock_bh(&vif_ctx_lnx->cmd_rsp_lock);
+}
+
 #ifndef CONFIG_NRF700X_RADIO_TEST
 struct wireless_dev *nrf_wifi_cfg80211_add_vif(struct wiphy *wiphy,
 					       const char *name,
@@ -129,7 +237,6 @@ int nrf_wifi_cfg80211_chg_vif(struct wiphy *wiphy, struct net_device *netdev,
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	struct nrf_wifi_umac_chg_vif_attr_info *vif_info = NULL;
 	int status = -1;
-	unsigned int count = 50;
 
 	wdev = netdev->ieee80211_ptr;
 
@@ -146,29 +253,26 @@ int nrf_wifi_cfg80211_chg_vif(struct wiphy *wiphy, struct net_device *netdev,
 	vif_info->iftype = iftype;
 	vif_info->nrf_wifi_use_4addr = params->use_4addr;
 
+	nrf_wifi_vif_cmd_begin(vif_ctx_lnx, NRF_WIFI_VIF_CMD_SET_IF);
+
 	status = nrf_wifi_fmac_chg_vif(rpu_ctx_lnx->rpu_ctx,
 				       vif_ctx_lnx->if_idx, vif_info);
 
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_set_vif failed\n", __func__);
-		goto out;
+		goto end;
 	}
 
 	pr_debug("%s: Waiting for response from RPU (change VIF)\n", __func__);
 
-	while (!vif_ctx_lnx->event_set_if && (count-- > 0))
-		msleep(1000);
-
-	if (!vif_ctx_lnx->event_set_if) {
-		status = -ETIMEDOUT;
-		pr_err("%s:Timed out waiting for response from RPU (change VIF)\n",
-		       __func__);
-		goto out;
-	}
+	status = nrf_wifi_vif_cmd_wait(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CHG_TIMEOUT_MS);
+	if (status)
+		goto end;
 
 	if (vif_ctx_lnx->status_set_if) {
 		status = vif_ctx_lnx->status_set_if;
-		goto out;
+		goto end;
 	}
 
 	nrf_wifi_fmac_vif_update_if_type(rpu_ctx_lnx->rpu_ctx,
@@ -176,9 +280,9 @@ int nrf_wifi_cfg80211_chg_vif(struct wiphy *wiphy, struct net_device *netdev,
 
 	wdev->iftype = iftype;
 
+end:
+	nrf_wifi_vif_cmd_end(vif_ctx_lnx);
 out:
-	vif_ctx_lnx->event_set_if = 0;
-
 	if (vif_info)
 		kfree(vif_info);
 
@@ -674,6 +778,8 @@ int nrf_wifi_cfg80211_del_sta(struct wiphy *wiphy, struct net_device *netdev,
 	vif_ctx_lnx = netdev_priv(wdev->netdev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
+	nrf_wifi_sta_cache_invalidate(vif_ctx_lnx);
+
 	del_sta_info = kzalloc(sizeof(*del_sta_info), GFP_KERNEL);
 
 	if (!del_sta_info) {
@@ -821,9 +927,233 @@ int nrf_wifi_cfg80211_set_txq_params(struct wiphy *wiphy,
 				     struct net_device *netdev,
 				     struct ieee80211_txq_params *params)
 {
-	pr_err("\n\n%s: Done in SET_BSS\n\n\n", __func__);
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct nrf_wifi_umac_cmd_set_wiphy *set_wiphy_cmd = NULL;
+	int status = -1;
 
-	return 0;
+	vif_ctx_lnx = netdev_priv(netdev);
+	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+
+	if (params->ac >= NL80211_NUM_ACS) {
+		pr_err("%s: Invalid AC %d\n", __func__, params->ac);
+		goto out;
+	}
+
+	set_wiphy_cmd = kzalloc(sizeof(*set_wiphy_cmd), GFP_KERNEL);
+
+	if (!set_wiphy_cmd) {
+		pr_err("%s: Unable to allocate memory\n", __func__);
+		goto out;
+	}
+
+	/* nrf_wifi_fmac_set_wiphy_params() cannot flag the TXQ parameters
+	 * as valid, so the command is built here
+	 */
+	set_wiphy_cmd->umac_hdr.cmd_evnt = NRF_WIFI_UMAC_CMD_SET_WIPHY;
+	set_wiphy_cmd->umac_hdr.ids.wdev_id = vif_ctx_lnx->if_idx;
+	set_wiphy_cmd->umac_hdr.ids.valid_fields |=
+		NRF_WIFI_INDEX_IDS_WDEV_ID_VALID;
+	set_wiphy_cmd->valid_fields |= NRF_WIFI_CMD_SET_WIPHY_TXQ_PARAMS_VALID;
+
+	/* Same AC numbering and units (TXOP in 32 us) as nl80211 */
+	set_wiphy_cmd->info.txq_params.ac = params->ac;
+	set_wiphy_cmd->info.txq_params.txop = params->txop;
+	set_wiphy_cmd->info.txq_params.cwmin = params->cwmin;
+	set_wiphy_cmd->info.txq_params.cwmax = params->cwmax;
+	set_wiphy_cmd->info.txq_params.aifs = params->aifs;
+
+	status = umac_cmd_cfg(rpu_ctx_lnx->rpu_ctx, set_wiphy_cmd,
+			      sizeof(*set_wiphy_cmd));
+
+	if (status != NRF_WIFI_STATUS_SUCCESS) {
+		pr_err("%s: Setting the TXQ parameters failed\n", __func__);
+		goto out;
+	}
+
+	vif_ctx_lnx->wmm_params[params->ac] = *params;
+	set_bit(params->ac, &vif_ctx_lnx->wmm_params_set);
+out:
+	if (set_wiphy_cmd)
+		kfree(set_wiphy_cmd);
+
+	return status;
+}
+
+void nrf_wifi_bss_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	spin_lock_init(&vif_ctx_lnx->bss_lock);
+	hash_init(vif_ctx_lnx->bss_hash);
+}
+
+/* Every scan reports each BSS it sees at least once */
+static void nrf_wifi_bss_reset(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	spin_lock_bh(&vif_ctx_lnx->bss_lock);
+	hash_init(vif_ctx_lnx->bss_hash);
+	vif_ctx_lnx->bss_count = 0;
+	spin_unlock_bh(&vif_ctx_lnx->bss_lock);
+}
+
+/* The TIM changes with every beacon, leave it out */
+static u32 nrf_wifi_bss_ie_crc(const u8 *ies, size_t ies_len)
+{
+	const struct element *elem = NULL;
+	u32 crc = ~0;
+
+	for_each_element(elem, ies, ies_len) {
+		if (elem->id == WLAN_EID_TIM)
+			continue;
+
+		crc = crc32_le(crc, (const u8 *)elem,
+			       sizeof(*elem) + elem->datalen);
+	}
+
+	return crc;
+}
+
+/* True if cfg80211 does not know the BSS yet, or it changed since it was
+ * last informed: different IEs, a significant signal change or close to
+ * expiring in cfg80211
+ */
+static bool
+nrf_wifi_bss_changed(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+		     const u8 *bssid, unsigned int freq, const u8 *ies,
+		     size_t ies_len, int signal)
+{
+	struct nrf_wifi_bss_entry *entry = NULL;
+	u64 key = ether_addr_to_u64(bssid) ^ freq;
+	u32 ie_crc = nrf_wifi_bss_ie_crc(ies, ies_len);
+	unsigned long refresh = msecs_to_jiffies(NRF_WIFI_BSS_REFRESH_MS);
+	bool changed = true;
+
+	spin_lock_bh(&vif_ctx_lnx->bss_lock);
+
+	hash_for_each_possible(vif_ctx_lnx->bss_hash, entry, node, key) {
+		if (entry->freq != freq ||
+		    !ether_addr_equal(entry->bssid, bssid))
+			continue;
+
+		if (entry->ie_crc == ie_crc &&
+		    abs(signal - entry->signal) < NRF_WIFI_BSS_SIGNAL_DELTA &&
+		    time_before(jiffies, entry->ts + refresh)) {
+			vif_ctx_lnx->bss_merged++;
+			changed = false;
+			goto out;
+		}
+
+		goto update;
+	}
+
+	/* Not tracked, cfg80211 sorts it out */
+	if (vif_ctx_lnx->bss_count == NRF_WIFI_BSS_TABLE_SIZE) {
+		vif_ctx_lnx->bss_table_full++;
+		goto inform;
+	}
+
+	entry = &vif_ctx_lnx->bss_table[vif_ctx_lnx->bss_count++];
+	ether_addr_copy(entry->bssid, bssid);
+	entry->freq = freq;
+	hash_add(vif_ctx_lnx->bss_hash, &entry->node, key);
+update:
+	entry->ie_crc = ie_crc;
+	entry->signal = signal;
+	entry->ts = jiffies;
+inform:
+	vif_ctx_lnx->bss_informed++;
+out:
+	spin_unlock_bh(&vif_ctx_lnx->bss_lock);
+
+	return changed;
+}
+
+/* Scan command for the given channels, all of them if there are none */
+static struct nrf_wifi_umac_scan_info *
+nrf_wifi_scan_info_alloc(struct ieee80211_channel **channels, int n_channels,
+			 struct cfg80211_ssid *ssids, int n_ssids,
+			 const u8 *ie, size_t ie_len, bool no_cck,
+			 unsigned int duration)
+{
+	struct nrf_wifi_umac_scan_info *scan_info = NULL;
+	struct nrf_wifi_scan_params *scan_params = NULL;
+	struct nrf_wifi_ssid *ssid = NULL;
+	unsigned int dwell_ms = 0;
+	int i = 0;
+
+	if (n_channels > NRF_WIFI_SCAN_MAX_NUM_FREQUENCIES)
+		return NULL;
+
+	if (ie_len > NRF_WIFI_MAX_IE_LEN)
+		return NULL;
+
+	scan_info = kzalloc((sizeof(*scan_info) +
+			     (sizeof(struct nrf_wifi_channel) * n_channels)),
+			    GFP_KERNEL);
+
+	if (!scan_info) {
+		pr_err("%s: Unable to allocate memory\n", __func__);
+		return NULL;
+	}
+
+	scan_params = &scan_info->scan_params;
+
+	/* Only the requested channels, cfg80211 lists all of them for a full
+	 * scan
+	 */
+	for (i = 0; i < n_channels; i++)
+		scan_params->channels[i].center_frequency =
+			channels[i]->center_freq;
+
+	scan_params->num_scan_channels = n_channels;
+
+	/* Same dwell on every channel, in TUs from userspace */
+	if (duration) {
+		dwell_ms = DIV_ROUND_UP(duration * 1024, 1000);
+		scan_params->dwell_time_active = dwell_ms;
+		scan_params->dwell_time_passive = dwell_ms;
+	}
+
+	scan_params->no_cck = no_cck;
+
+	if (ie_len) {
+		memcpy(scan_params->ie.ie, ie, ie_len);
+		scan_params->ie.ie_len = ie_len;
+	}
+
+	if (!n_ssids)
+		scan_params->passive_scan = 1;
+
+	for (i = 0; i < n_ssids; i++) {
+		if (ssids[i].ssid_len == 0)
+			continue;
+
+		if (ssids[i].ssid_len > NRF_WIFI_MAX_SSID_LEN) {
+			pr_err("%s: SSID length is too long %d\n", __func__,
+			       ssids[i].ssid_len);
+			goto err;
+		}
+
+		if (scan_params->num_scan_ssids ==
+		    NRF_WIFI_SCAN_MAX_NUM_SSIDS) {
+			pr_err("%s: Max number of SSIDs reached\n", __func__);
+			goto err;
+		}
+
+		/* Wildcard SSIDs are skipped, do not leave holes for them */
+		ssid = &scan_params->scan_ssids[scan_params->num_scan_ssids];
+
+		memcpy(ssid->nrf_wifi_ssid, ssids[i].ssid, ssids[i].ssid_len);
+
+		ssid->nrf_wifi_ssid_len = ssids[i].ssid_len;
+
+		scan_params->num_scan_ssids++;
+	}
+
+	return scan_info;
+err:
+	kfree(scan_info);
+
+	return NULL;
 }
 
 int nrf_wifi_cfg80211_scan(struct wiphy *wiphy,
@@ -833,7 +1163,7 @@ int nrf_wifi_cfg80211_scan(struct wiphy *wiphy,
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	struct nrf_wifi_umac_scan_info *scan_info = NULL;
-	int status = -1, i;
+	int status = -1;
 	wdev = req->wdev;
 
 	if (wdev->iftype == NL80211_IFTYPE_AP)
@@ -842,67 +1172,246 @@ int nrf_wifi_cfg80211_scan(struct wiphy *wiphy,
 	if (req->n_channels > NRF_WIFI_SCAN_MAX_NUM_FREQUENCIES)
 		return -EINVAL;
 
+	if (req->ie_len > NRF_WIFI_MAX_IE_LEN)
+		return -EINVAL;
+
 	rpu_ctx_lnx = wiphy_priv(wiphy);
 	vif_ctx_lnx = netdev_priv(wdev->netdev);
 
-	req->n_channels = 0;
-	scan_info =
-		kzalloc((sizeof(*scan_info) +
-			 (sizeof(struct nrf_wifi_channel) * req->n_channels)),
-			GFP_KERNEL);
+	/* The RPU runs one scan at a time */
+	mutex_lock(&vif_ctx_lnx->sched_scan_lock);
+	if (vif_ctx_lnx->sched_scan_active) {
+		status = -EBUSY;
+		goto out;
+	}
 
-	if (!scan_info) {
-		pr_err("%s: Unable to allocate memory\n", __func__);
+	scan_info = nrf_wifi_scan_info_alloc(req->channels, req->n_channels,
+					     req->ssids, req->n_ssids, req->ie,
+					     req->ie_len, req->no_cck,
+					     req->duration);
+	if (!scan_info)
+		goto out;
+
+	nrf_wifi_bss_reset(vif_ctx_lnx);
+
+	scan_info->scan_reason = SCAN_DISPLAY;
+	status = nrf_wifi_fmac_scan(rpu_ctx_lnx->rpu_ctx, vif_ctx_lnx->if_idx,
+				    scan_info);
+
+	if (status == NRF_WIFI_STATUS_FAIL) {
+		pr_err("%s: nrf_wifi_fmac_scan failed\n", __func__);
 		goto out;
 	}
 
-	if (!req->n_ssids)
-		scan_info->scan_params.passive_scan = 1;
+	vif_ctx_lnx->nrf_wifi_scan_req = req;
+	vif_ctx_lnx->scan_start = ktime_get();
 
-	for (i = 0; i < req->n_ssids; i++) {
-		if (req->ssids[i].ssid_len == 0)
-			continue;
+	get_scan_results = 0;
 
-		if (req->ssids[i].ssid_len > NRF_WIFI_MAX_SSID_LEN) {
-			pr_err("%s: SSID length is too long %d\n", __func__,
-			       req->ssids[i].ssid_len);
-			goto out;
-		}
+out:
+	mutex_unlock(&vif_ctx_lnx->sched_scan_lock);
 
-		if (scan_info->scan_params.num_scan_ssids ==
-		    NRF_WIFI_SCAN_MAX_NUM_SSIDS) {
-			pr_err("%s: Max number of SSIDs reached\n", __func__);
-			goto out;
-		}
+	if (scan_info)
+		kfree(scan_info);
+	return status;
+}
 
-		memcpy(scan_info->scan_params.scan_ssids[i].nrf_wifi_ssid,
-		       req->ssids[i].ssid, req->ssids[i].ssid_len);
+static void nrf_wifi_sched_scan_work(struct work_struct *work)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
+	struct cfg80211_sched_scan_request *req = NULL;
+	struct nrf_wifi_umac_scan_info *scan_info = NULL;
+	int status = -1;
 
-		scan_info->scan_params.scan_ssids[i].nrf_wifi_ssid_len =
-			req->ssids[i].ssid_len;
+	vif_ctx_lnx = container_of(to_delayed_work(work),
+				   struct nrf_wifi_fmac_vif_ctx_lnx,
+				   ws_sched_scan);
+	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+
+	mutex_lock(&vif_ctx_lnx->sched_scan_lock);
+
+	req = vif_ctx_lnx->sched_scan_req;
+	if (!req)
+		goto out;
 
-		scan_info->scan_params.num_scan_ssids++;
+	/* Skip this iteration if the RPU is busy with a requested scan */
+	if (vif_ctx_lnx->nrf_wifi_scan_req) {
+		schedule_delayed_work(&vif_ctx_lnx->ws_sched_scan,
+				      msecs_to_jiffies(MSEC_PER_SEC));
+		goto out;
 	}
 
+	scan_info = nrf_wifi_scan_info_alloc(req->channels, req->n_channels,
+					     req->ssids, req->n_ssids, req->ie,
+					     req->ie_len, false, 0);
+	if (!scan_info)
+		goto out;
+
+	nrf_wifi_bss_reset(vif_ctx_lnx);
+
 	scan_info->scan_reason = SCAN_DISPLAY;
 	status = nrf_wifi_fmac_scan(rpu_ctx_lnx->rpu_ctx, vif_ctx_lnx->if_idx,
 				    scan_info);
 
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_scan failed\n", __func__);
+		/* Try again with the next iteration */
+		schedule_delayed_work(&vif_ctx_lnx->ws_sched_scan,
+				      msecs_to_jiffies(MSEC_PER_SEC));
 		goto out;
 	}
 
-	vif_ctx_lnx->nrf_wifi_scan_req = req;
+	vif_ctx_lnx->sched_scan_active = true;
+	vif_ctx_lnx->sched_scan_matched = false;
+	vif_ctx_lnx->sched_scans++;
+out:
+	mutex_unlock(&vif_ctx_lnx->sched_scan_lock);
 
-	get_scan_results = 0;
+	kfree(scan_info);
+}
+
+/* Reports the iteration if it found a match and schedules the next one
+ * following the scan plans
+ */
+static void
+nrf_wifi_sched_scan_done(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	struct cfg80211_sched_scan_request *req = NULL;
+	struct cfg80211_sched_scan_plan *plan = NULL;
+
+	vif_ctx_lnx->sched_scan_active = false;
+
+	req = vif_ctx_lnx->sched_scan_req;
+	if (!req)
+		return;
+
+	if (vif_ctx_lnx->sched_scan_matched) {
+		vif_ctx_lnx->sched_scan_matches++;
+		cfg80211_sched_scan_results(vif_ctx_lnx->wdev->wiphy,
+					    req->reqid);
+	}
+
+	plan = &req->scan_plans[vif_ctx_lnx->sched_scan_plan];
+
+	/* The last plan has no iteration limit */
+	if (plan->iterations &&
+	    ++vif_ctx_lnx->sched_scan_iter >= plan->iterations &&
+	    vif_ctx_lnx->sched_scan_plan + 1 < req->n_scan_plans) {
+		vif_ctx_lnx->sched_scan_plan++;
+		vif_ctx_lnx->sched_scan_iter = 0;
+		plan = &req->scan_plans[vif_ctx_lnx->sched_scan_plan];
+	}
+
+	schedule_delayed_work(&vif_ctx_lnx->ws_sched_scan,
+			      msecs_to_jiffies(plan->interval * MSEC_PER_SEC));
+}
+
+static bool
+nrf_wifi_sched_scan_match(struct cfg80211_sched_scan_request *req,
+			  struct nrf_wifi_umac_event_new_scan_results *res)
+{
+	struct cfg80211_match_set *match = NULL;
+	const u8 *ssid_ie = NULL;
+	int signal = 0;
+	int i = 0;
+
+	if (res->signal.signal_type == NRF_WIFI_SIGNAL_TYPE_MBM)
+		signal = MBM_TO_DBM(res->signal.signal.mbm_signal);
+	else
+		signal = res->signal.signal.unspec_signal;
+
+	ssid_ie = cfg80211_find_ie(WLAN_EID_SSID, res->ies, res->ies_len);
+
+	/* No match sets, every BSS is a match */
+	if (!req->n_match_sets)
+		return signal >= req->min_rssi_thold;
+
+	for (i = 0; i < req->n_match_sets; i++) {
+		match = &req->match_sets[i];
+
+		if (!is_zero_ether_addr(match->bssid) &&
+		    !ether_addr_equal(match->bssid, res->mac_addr))
+			continue;
+
+		if (match->ssid.ssid_len &&
+		    (!ssid_ie || ssid_ie[1] != match->ssid.ssid_len ||
+		     memcmp(ssid_ie + 2, match->ssid.ssid,
+			    match->ssid.ssid_len)))
+			continue;
+
+		if (signal < match->rssi_thold)
+			continue;
+
+		return true;
+	}
+
+	return false;
+}
+
+void nrf_wifi_sched_scan_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	mutex_init(&vif_ctx_lnx->sched_scan_lock);
+	INIT_DELAYED_WORK(&vif_ctx_lnx->ws_sched_scan,
+			  nrf_wifi_sched_scan_work);
+}
+
+void nrf_wifi_sched_scan_deinit(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	cancel_delayed_work_sync(&vif_ctx_lnx->ws_sched_scan);
+}
+
+/* The UMAC has no scheduled scan, the host runs the scan plans and only
+ * reports iterations which found one of the match sets
+ */
+int nrf_wifi_cfg80211_sched_scan_start(struct wiphy *wiphy,
+				       struct net_device *dev,
+				       struct cfg80211_sched_scan_request *req)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	int status = 0;
+
+	vif_ctx_lnx = netdev_priv(dev);
+
+	if (req->n_channels > NRF_WIFI_SCAN_MAX_NUM_FREQUENCIES)
+		return -EINVAL;
+
+	mutex_lock(&vif_ctx_lnx->sched_scan_lock);
+
+	if (vif_ctx_lnx->sched_scan_req) {
+		status = -EBUSY;
+		goto out;
+	}
+
+	vif_ctx_lnx->sched_scan_req = req;
+	vif_ctx_lnx->sched_scan_plan = 0;
+	vif_ctx_lnx->sched_scan_iter = 0;
 
+	schedule_delayed_work(&vif_ctx_lnx->ws_sched_scan,
+			      msecs_to_jiffies(req->delay * MSEC_PER_SEC));
 out:
-	if (scan_info)
-		kfree(scan_info);
+	mutex_unlock(&vif_ctx_lnx->sched_scan_lock);
+
 	return status;
 }
 
+int nrf_wifi_cfg80211_sched_scan_stop(struct wiphy *wiphy,
+				      struct net_device *dev, u64 reqid)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+
+	vif_ctx_lnx = netdev_priv(dev);
+
+	/* A scan already started completes, nothing is reported for it */
+	mutex_lock(&vif_ctx_lnx->sched_scan_lock);
+	vif_ctx_lnx->sched_scan_req = NULL;
+	mutex_unlock(&vif_ctx_lnx->sched_scan_lock);
+
+	cancel_delayed_work_sync(&vif_ctx_lnx->ws_sched_scan);
+
+	return 0;
+}
+
 void nrf_wifi_cfg80211_scan_start_callbk_fn(
 	void *os_vif_ctx,
 	struct nrf_wifi_umac_event_trigger_scan *scan_start_event,
@@ -920,15 +1429,17 @@ static void nrf_wifi_cfg80211_scan_results(
 	struct net_device *dev,
 	struct nrf_wifi_umac_event_new_scan_results *new_scan_results)
 {
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	struct wireless_dev *wdev = NULL;
 	struct wiphy *wiphy = NULL;
 	struct ieee80211_channel *rx_channel = NULL;
 	enum cfg80211_bss_frame_type ftype = CFG80211_BSS_FTYPE_BEACON;
-	char *ie = NULL;
+	const u8 *ie = NULL;
 	int signal = 0;
 	int ielen = 0;
 	struct cfg80211_bss *res = NULL;
 
+	vif_ctx_lnx = netdev_priv(dev);
 	wdev = dev->ieee80211_ptr;
 	wiphy = wdev->wiphy;
 
@@ -939,6 +1450,16 @@ static void nrf_wifi_cfg80211_scan_results(
 		signal = new_scan_results->signal.signal.unspec_signal;
 
 	rx_channel = ieee80211_get_channel(wiphy, new_scan_results->frequency);
+	if (!rx_channel)
+		return;
+
+	ie = new_scan_results->ies;
+	ielen = new_scan_results->ies_len;
+
+	if (!nrf_wifi_bss_changed(vif_ctx_lnx, new_scan_results->mac_addr,
+				  new_scan_results->frequency, ie, ielen,
+				  signal))
+		return;
 
 	res = cfg80211_inform_bss_width(
 		wiphy, rx_channel, NL80211_BSS_CHAN_WIDTH_20, ftype,
@@ -946,20 +1467,44 @@ static void nrf_wifi_cfg80211_scan_results(
 		new_scan_results->capability, new_scan_results->beacon_interval,
 		ie, ielen, signal, GFP_KERNEL);
 
-	/* cfg80211_put_bss(res) ?? */
+	if (res)
+		cfg80211_put_bss(wiphy, res);
 }
 
 static void
 nrf_wifi_cfg80211_scan_done(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
 			    int aborted)
 {
+	unsigned int scan_us = 0;
+
+	mutex_lock(&vif_ctx_lnx->sched_scan_lock);
+
+	if (vif_ctx_lnx->sched_scan_active) {
+		nrf_wifi_sched_scan_done(vif_ctx_lnx);
+		goto out;
+	}
+
 	if (vif_ctx_lnx->nrf_wifi_scan_req) {
 		struct cfg80211_scan_info info = {};
 
+		scan_us = ktime_us_delta(ktime_get(), vif_ctx_lnx->scan_start);
+
+		if (!vif_ctx_lnx->scans || scan_us < vif_ctx_lnx->scan_min_us)
+			vif_ctx_lnx->scan_min_us = scan_us;
+		vif_ctx_lnx->scan_max_us =
+			max(vif_ctx_lnx->scan_max_us, scan_us);
+		vif_ctx_lnx->scan_last_us = scan_us;
+		vif_ctx_lnx->scan_total_us += scan_us;
+		vif_ctx_lnx->scans++;
+		if (aborted)
+			vif_ctx_lnx->scans_aborted++;
+
 		info.aborted = aborted;
 		cfg80211_scan_done(vif_ctx_lnx->nrf_wifi_scan_req, &info);
 		vif_ctx_lnx->nrf_wifi_scan_req = NULL;
 	}
+out:
+	mutex_unlock(&vif_ctx_lnx->sched_scan_lock);
 }
 
 void nrf_wifi_cfg80211_rx_bcn_prb_rsp_callbk_fn(void *os_vif_ctx, void *frm,
@@ -973,20 +1518,33 @@ void nrf_wifi_cfg80211_rx_bcn_prb_rsp_callbk_fn(void *os_vif_ctx, void *frm,
 	struct cfg80211_inform_bss bss_meta = {};
 	unsigned int len = 0;
 	struct cfg80211_bss *bss = NULL;
+	/* Beacons and probe responses share the layout up to the IEs */
+	size_t ies_off = offsetof(struct ieee80211_mgmt, u.beacon.variable);
 	vif_ctx_lnx = os_vif_ctx;
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 	skb = frm;
 	mgmt = (struct ieee80211_mgmt *)skb->data;
 	len = skb->len;
-	if (skb->len < 24 || (!ieee80211_is_probe_resp(mgmt->frame_control) &&
-			      !ieee80211_is_beacon(mgmt->frame_control))) {
+	if (skb->len < ies_off ||
+	    (!ieee80211_is_probe_resp(mgmt->frame_control) &&
+	     !ieee80211_is_beacon(mgmt->frame_control))) {
 		return;
 	}
 	bss_meta.scan_width = NL80211_BSS_CHAN_WIDTH_20;
 	bss_meta.signal = signal;
 	bss_meta.chan = ieee80211_get_channel(rpu_ctx_lnx->wiphy, frequency);
+	if (!bss_meta.chan)
+		return;
+
+	if (!nrf_wifi_bss_changed(vif_ctx_lnx, mgmt->bssid, frequency,
+				  mgmt->u.beacon.variable, len - ies_off,
+				  signal))
+		return;
+
 	bss = cfg80211_inform_bss_frame_data(rpu_ctx_lnx->wiphy, &bss_meta,
 					     mgmt, len, GFP_ATOMIC);
+	if (bss)
+		cfg80211_put_bss(rpu_ctx_lnx->wiphy, bss);
 }
 
 void nrf_wifi_cfg80211_scan_res_callbk_fn(
@@ -1001,6 +1559,13 @@ void nrf_wifi_cfg80211_scan_res_callbk_fn(
 
 	nrf_wifi_cfg80211_scan_results(vif_ctx_lnx->netdev, scan_res);
 
+	mutex_lock(&vif_ctx_lnx->sched_scan_lock);
+	if (vif_ctx_lnx->sched_scan_active && vif_ctx_lnx->sched_scan_req &&
+	    !vif_ctx_lnx->sched_scan_matched)
+		vif_ctx_lnx->sched_scan_matched = nrf_wifi_sched_scan_match(
+			vif_ctx_lnx->sched_scan_req, scan_res);
+	mutex_unlock(&vif_ctx_lnx->sched_scan_lock);
+
 	if (!more_res)
 		nrf_wifi_cfg80211_scan_done(vif_ctx_lnx, false);
 }
@@ -1119,6 +1684,19 @@ int nrf_wifi_cfg80211_auth(struct wiphy *wiphy, struct net_device *netdev,
 				WLAN_CIPHER_SUITE_WEP104;
 	}
 
+	/* FT authentication carries the MDE and FTE built by userspace */
+	if (req->ie_len) {
+		if (req->ie_len > NRF_WIFI_MAX_IE_LEN) {
+			pr_err("%s: IE len (%zu) exceeds max length (%d)\n",
+			       __func__, req->ie_len, NRF_WIFI_MAX_IE_LEN);
+			status = -1;
+			goto out;
+		}
+
+		memcpy(auth_info->ie.ie, req->ie, req->ie_len);
+		auth_info->ie.ie_len = req->ie_len;
+	}
+
 	if (req->auth_data_len) {
 		auth_info->sae.sae_data_len = req->auth_data_len;
 		memcpy(auth_info->sae.sae_data, req->auth_data,
@@ -1137,11 +1715,20 @@ int nrf_wifi_cfg80211_auth(struct wiphy *wiphy, struct net_device *netdev,
 			       auth_info->sae.sae_data_len, 1);
 #endif
 	}
+	/* Only the first authentication frame starts the connect timer,
+	 * SAE and FT send more than one
+	 */
+	if (!vif_ctx_lnx->connect_pending) {
+		vif_ctx_lnx->connect_start = ktime_get();
+		vif_ctx_lnx->connect_pending = true;
+	}
+
 	status = nrf_wifi_fmac_auth(rpu_ctx_lnx->rpu_ctx, vif_ctx_lnx->if_idx,
 				    auth_info);
 
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_auth failed\n", __func__);
+		vif_ctx_lnx->connect_pending = false;
 		goto out;
 	}
 
@@ -1152,6 +1739,41 @@ out:
 	return status;
 }
 
+/* Whether an authentication or association event ends the connect attempt,
+ * by a timeout or by a status refusing it. The next authentication starts
+ * the connect timer again.
+ */
+static bool
+nrf_wifi_connect_failed(struct nrf_wifi_umac_event_mlme *mlme_event)
+{
+	struct ieee80211_mgmt *mgmt = NULL;
+	unsigned int len = mlme_event->frame.frame_len;
+	u16 status_code = WLAN_STATUS_SUCCESS;
+
+	if (mlme_event->nrf_wifi_flags & NRF_WIFI_EVENT_MLME_TIMED_OUT)
+		return true;
+
+	if (len < offsetofend(struct ieee80211_mgmt, u.assoc_resp.status_code))
+		return false;
+
+	mgmt = (struct ieee80211_mgmt *)mlme_event->frame.frame;
+
+	if (!ieee80211_is_auth(mgmt->frame_control))
+		return le16_to_cpu(mgmt->u.assoc_resp.status_code) !=
+		       WLAN_STATUS_SUCCESS;
+
+	if (len < offsetofend(struct ieee80211_mgmt, u.auth.status_code))
+		return false;
+
+	status_code = le16_to_cpu(mgmt->u.auth.status_code);
+
+	/* SAE goes on after these */
+	return status_code != WLAN_STATUS_SUCCESS &&
+	       status_code != WLAN_STATUS_ANTI_CLOG_REQUIRED &&
+	       status_code != WLAN_STATUS_SAE_HASH_TO_ELEMENT &&
+	       status_code != WLAN_STATUS_SAE_PK;
+}
+
 void nrf_wifi_cfg80211_auth_resp_callbk_fn(
 	void *os_vif_ctx, struct nrf_wifi_umac_event_mlme *auth_resp_event,
 	unsigned int event_len)
@@ -1160,6 +1782,9 @@ void nrf_wifi_cfg80211_auth_resp_callbk_fn(
 
 	vif_ctx_lnx = os_vif_ctx;
 
+	if (nrf_wifi_connect_failed(auth_resp_event))
+		vif_ctx_lnx->connect_pending = false;
+
 	cfg80211_rx_mlme_mgmt(vif_ctx_lnx->netdev, auth_resp_event->frame.frame,
 			      auth_resp_event->frame.frame_len);
 }
@@ -1208,6 +1833,15 @@ int nrf_wifi_cfg80211_assoc(struct wiphy *wiphy, struct net_device *netdev,
 
 	memcpy(assoc_info->ssid.nrf_wifi_ssid, ssid_ie + 2, ssid_ie[1]);
 
+	/* Reassociation within the ESS, e.g. after an FT authentication */
+	if (req->prev_bssid) {
+		assoc_info->prev_bssid_flag = 1;
+		memcpy(assoc_info->prev_bssid, req->prev_bssid, ETH_ALEN);
+	}
+
+	/* Counted as a roam once the carrier comes up */
+	vif_ctx_lnx->connect_roam = !!req->prev_bssid;
+
 	/* WPA-IE */
 	assoc_info->wpa_ie.ie_len = req->ie_len;
 
@@ -1223,6 +1857,7 @@ int nrf_wifi_cfg80211_assoc(struct wiphy *wiphy, struct net_device *netdev,
 
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_assoc failed\n", __func__);
+		vif_ctx_lnx->connect_pending = false;
 		goto out;
 	}
 
@@ -1241,6 +1876,9 @@ void nrf_wifi_cfg80211_assoc_resp_callbk_fn(
 
 	vif_ctx_lnx = os_vif_ctx;
 
+	if (nrf_wifi_connect_failed(assoc_resp_event))
+		vif_ctx_lnx->connect_pending = false;
+
 	cfg80211_rx_assoc_resp(vif_ctx_lnx->netdev, vif_ctx_lnx->bss,
 			       assoc_resp_event->frame.frame,
 			       assoc_resp_event->frame.frame_len, -1, NULL, 0);
@@ -1260,6 +1898,10 @@ int nrf_wifi_cfg80211_deauth(struct wiphy *wiphy, struct net_device *netdev,
 	vif_ctx_lnx = netdev_priv(netdev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
+	/* An abandoned attempt does not count as a connect */
+	vif_ctx_lnx->connect_pending = false;
+	nrf_wifi_sta_cache_invalidate(vif_ctx_lnx);
+
 	deauth_info = kzalloc(sizeof(*deauth_info), GFP_KERNEL);
 
 	if (!deauth_info) {
@@ -1298,6 +1940,8 @@ void nrf_wifi_cfg80211_deauth_callbk_fn(
 
 	vif_ctx_lnx = os_vif_ctx;
 
+	nrf_wifi_sta_cache_invalidate(vif_ctx_lnx);
+
 	cfg80211_tx_mlme_mgmt(vif_ctx_lnx->netdev, deauth_event->frame.frame,
 			      deauth_event->frame.frame_len, false);
 }
@@ -1316,6 +1960,10 @@ int nrf_wifi_cfg80211_disassoc(struct wiphy *wiphy, struct net_device *netdev,
 	vif_ctx_lnx = netdev_priv(netdev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
+	/* An abandoned attempt does not count as a connect */
+	vif_ctx_lnx->connect_pending = false;
+	nrf_wifi_sta_cache_invalidate(vif_ctx_lnx);
+
 	disassoc_info = kzalloc(sizeof(*disassoc_info), GFP_KERNEL);
 
 	if (!disassoc_info) {
@@ -1357,6 +2005,8 @@ void nrf_wifi_cfg80211_disassoc_callbk_fn(
 
 	vif_ctx_lnx = os_vif_ctx;
 
+	nrf_wifi_sta_cache_invalidate(vif_ctx_lnx);
+
 	cfg80211_tx_mlme_mgmt(vif_ctx_lnx->netdev, disassoc_event->frame.frame,
 			      disassoc_event->frame.frame_len, false);
 }
@@ -1507,28 +2157,15 @@ void nrf_wifi_cfg80211_tx_status_callbk_fn(
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	unsigned long long host_cookie = 0;
-	struct cookie_info *cookie_info = NULL;
-	struct cookie_info *tmp = NULL;
 	bool ack_event = false;
 
 	vif_ctx_lnx = os_vif_ctx;
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
-	list_for_each_entry_safe(cookie_info, tmp, &rpu_ctx_lnx->cookie_list,
-				 list) {
-		if (cookie_info->rpu_cookie != tx_status_event->cookie)
-			continue;
-
-		host_cookie = cookie_info->host_cookie;
-
-		pr_err("%s: found cookie = %llu\n", __func__, host_cookie);
-
-		list_del(&cookie_info->list);
-		kfree(cookie_info);
-	}
-
-	if (host_cookie == 0)
-		pr_err("cookie not found\n\n");
+	if (!nrf_wifi_cookie_get(&rpu_ctx_lnx->cookies,
+				 tx_status_event->cookie, &host_cookie, true))
+		pr_err("%s: cookie %llu not found\n", __func__,
+		       tx_status_event->cookie);
 
 	ack_event = tx_status_event->nrf_wifi_flags & NRF_WIFI_EVENT_MLME_ACK ?
 			    true :
@@ -1609,29 +2246,15 @@ void nrf_wifi_cfg80211_roc_callbk_fn(
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	unsigned long long host_cookie = 0;
-	struct cookie_info *cookie_info = NULL;
-	struct cookie_info *tmp = NULL;
-	int match_cookie_found = 0;
 	struct ieee80211_channel *chan = NULL;
 	unsigned int duration = 0;
 
 	vif_ctx_lnx = os_vif_ctx;
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
-	list_for_each_entry_safe(cookie_info, tmp, &rpu_ctx_lnx->cookie_list,
-				 list) {
-		if (cookie_info) {
-			if (cookie_info->rpu_cookie != roc_event->cookie)
-				continue;
-
-			host_cookie = cookie_info->host_cookie;
-			match_cookie_found = 1;
-
-			break;
-		}
-	}
-
-	if (match_cookie_found) {
+	/* Kept until the remain on channel expires */
+	if (nrf_wifi_cookie_get(&rpu_ctx_lnx->cookies, roc_event->cookie,
+				&host_cookie, false)) {
 		chan = ieee80211_get_channel(rpu_ctx_lnx->wiphy,
 					     roc_event->frequency);
 
@@ -1666,36 +2289,20 @@ void nrf_wifi_cfg80211_roc_cancel_callbk_fn(
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	unsigned long long host_cookie = 0;
-	struct cookie_info *cookie_info = NULL;
-	struct cookie_info *tmp = NULL;
-	int match_cookie_found = 0;
 	struct ieee80211_channel *chan = NULL;
 
 	vif_ctx_lnx = os_vif_ctx;
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
-	list_for_each_entry_safe(cookie_info, tmp, &rpu_ctx_lnx->cookie_list,
-				 list) {
-		if (cookie_info) {
-			if (cookie_info->rpu_cookie != roc_cancel_event->cookie)
-				continue;
-			host_cookie = cookie_info->host_cookie;
-			match_cookie_found = 1;
-			break;
-		}
+	if (!nrf_wifi_cookie_get(&rpu_ctx_lnx->cookies,
+				 roc_cancel_event->cookie, &host_cookie, true))
+		return;
 
-		if (match_cookie_found) {
-			chan = ieee80211_get_channel(
-				rpu_ctx_lnx->wiphy,
-				roc_cancel_event->frequency);
+	chan = ieee80211_get_channel(rpu_ctx_lnx->wiphy,
+				     roc_cancel_event->frequency);
 
-			cfg80211_remain_on_channel_expired(vif_ctx_lnx->wdev,
-							   host_cookie, chan,
-							   GFP_KERNEL);
-			list_del(&cookie_info->list);
-			kfree(cookie_info);
-		}
-	}
+	cfg80211_remain_on_channel_expired(vif_ctx_lnx->wdev, host_cookie, chan,
+					   GFP_KERNEL);
 }
 
 int nrf_wifi_cfg80211_probe_client(struct wiphy *wiphy,
@@ -2083,42 +2690,123 @@ static void sta_set_sinfo(struct nrf_wifi_sta_info *sta,
 	}
 }
 
+/* A station cached before a disconnect must not be reported after it */
+void
+nrf_wifi_sta_cache_invalidate(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	atomic_inc(&vif_ctx_lnx->sta_cache_gen);
+	/* Pairs with the smp_mb() in nrf_wifi_cfg80211_get_station() */
+	smp_mb__after_atomic();
+	WRITE_ONCE(vif_ctx_lnx->sta_cache_valid, false);
+}
+
+/* Answers get_station from the last firmware response while it is younger
+ * than sta_info_ttl_ms. A STA reports the signal of the last frame received
+ * from its AP instead of the cached one.
+ */
+static bool
+nrf_wifi_sta_cache_get(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+		       const u8 *mac, struct station_info *sinfo)
+{
+	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
+	unsigned int ttl_ms = READ_ONCE(sta_info_ttl_ms);
+	unsigned long now_us = 0;
+	unsigned long age_ms = 0;
+	bool hit = false;
+
+	fmac_dev_ctx = vif_ctx_lnx->rpu_ctx->rpu_ctx;
+
+	mutex_lock(&vif_ctx_lnx->cmd_lock);
+
+	if (!ttl_ms || !READ_ONCE(vif_ctx_lnx->sta_cache_valid) ||
+	    !ether_addr_equal(vif_ctx_lnx->sta_cache_mac, mac))
+		goto out;
+
+	now_us = nrf_wifi_osal_time_get_curr_us(fmac_dev_ctx->fpriv->opriv);
+	age_ms = (now_us - vif_ctx_lnx->sta_cache_ts_us) / USEC_PER_MSEC;
+	if (age_ms >= ttl_ms)
+		goto out;
+
+	sta_set_sinfo(&vif_ctx_lnx->station_info, sinfo);
+
+	if (sinfo->filled & BIT(NL80211_STA_INFO_CONNECTED_TIME))
+		sinfo->connected_time += age_ms / MSEC_PER_SEC;
+
+	if (vif_ctx_lnx->wdev->iftype == NL80211_IFTYPE_STATION &&
+	    vif_ctx_lnx->rssi_record_timestamp_us &&
+	    (now_us - vif_ctx_lnx->rssi_record_timestamp_us) / USEC_PER_MSEC <
+		    ttl_ms) {
+		sinfo->signal = vif_ctx_lnx->rssi;
+		sinfo->filled |= BIT(NL80211_STA_INFO_SIGNAL);
+	}
+
+	hit = true;
+out:
+	if (hit)
+		vif_ctx_lnx->sta_cache_hits++;
+	else
+		vif_ctx_lnx->sta_cache_misses++;
+
+	mutex_unlock(&vif_ctx_lnx->cmd_lock);
+
+	return hit;
+}
+
 int nrf_wifi_cfg80211_get_station(struct wiphy *wiphy, struct net_device *dev,
 				  const u8 *mac, struct station_info *sinfo)
 {
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
-	unsigned int count = 50;
+	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
+	int cache_gen = 0;
 	int status = 0;
 
 	vif_ctx_lnx = netdev_priv(dev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
+
+	if (nrf_wifi_sta_cache_get(vif_ctx_lnx, mac, sinfo))
+		return 0;
+
+	nrf_wifi_vif_cmd_begin(vif_ctx_lnx, NRF_WIFI_VIF_CMD_GET_STATION);
+
+	/* The response overwrites the cached station */
+	WRITE_ONCE(vif_ctx_lnx->sta_cache_valid, false);
+	cache_gen = atomic_read(&vif_ctx_lnx->sta_cache_gen);
 
 	status = nrf_wifi_fmac_get_station(rpu_ctx_lnx->rpu_ctx,
 					   vif_ctx_lnx->if_idx, (void *)mac);
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_get_station failed\n", __func__);
-		return -EIO;
+		status = -EIO;
+		goto out;
 	}
 
 	pr_debug("%s: Waiting for response from RPU (Get STA)\n", __func__);
 
-	while (!vif_ctx_lnx->station_info && (count-- > 0))
-		msleep(100);
-
-	if (!vif_ctx_lnx->station_info) {
-		pr_err("%s:Timed out waiting for response from RPU (Get STA) \n",
-		       __func__);
-		return -ETIMEDOUT;
-	}
+	status = nrf_wifi_vif_cmd_wait(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CMD_TIMEOUT_MS);
+	if (status)
+		goto out;
 
-	sta_set_sinfo(vif_ctx_lnx->station_info, sinfo);
+	sta_set_sinfo(&vif_ctx_lnx->station_info, sinfo);
 
-	kfree(vif_ctx_lnx->station_info);
+	ether_addr_copy(vif_ctx_lnx->sta_cache_mac, mac);
+	vif_ctx_lnx->sta_cache_ts_us =
+		nrf_wifi_osal_time_get_curr_us(fmac_dev_ctx->fpriv->opriv);
+	WRITE_ONCE(vif_ctx_lnx->sta_cache_valid, true);
 
-	vif_ctx_lnx->station_info = NULL;
+	/* An invalidate from a disconnect event may have raced the response,
+	 * either before the flag was set above or after the check below.
+	 * Both orders leave the cache invalid.
+	 */
+	smp_mb();
+	if (atomic_read(&vif_ctx_lnx->sta_cache_gen) != cache_gen)
+		WRITE_ONCE(vif_ctx_lnx->sta_cache_valid, false);
+out:
+	nrf_wifi_vif_cmd_end(vif_ctx_lnx);
 
-	return 0;
+	return status;
 }
 
 int nrf_wifi_cfg80211_get_tx_power(struct wiphy *wiphy,
@@ -2126,43 +2814,39 @@ int nrf_wifi_cfg80211_get_tx_power(struct wiphy *wiphy,
 {
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
-	unsigned int count = 50;
 	int status = 0;
 
 	vif_ctx_lnx = netdev_priv(wdev->netdev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
-	vif_ctx_lnx->event_tx_power = 0;
-
 	if (!(wdev->netdev->flags & IFF_UP)) {
 		pr_debug("%s: Interface is not UP\n", __func__);
 		return -ENETDOWN;
 	}
 
+	nrf_wifi_vif_cmd_begin(vif_ctx_lnx, NRF_WIFI_VIF_CMD_GET_TX_POWER);
+
 	status = nrf_wifi_fmac_get_tx_power(rpu_ctx_lnx->rpu_ctx,
 					    vif_ctx_lnx->if_idx);
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_get_tx_power failed\n", __func__);
-		return -EIO;
+		status = -EIO;
+		goto out;
 	}
 
 	pr_debug("%s: Waiting for response from RPU (Get TX power)\n",
 		 __func__);
 
-	while (!vif_ctx_lnx->event_tx_power && (count-- > 0))
-		msleep(100);
-
-	if (!vif_ctx_lnx->event_tx_power) {
-		pr_err("%s:Timed out waiting for response from RPU (Set TX power) \n",
-		       __func__);
-		return -ETIMEDOUT;
-	}
+	status = nrf_wifi_vif_cmd_wait(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CMD_TIMEOUT_MS);
+	if (status)
+		goto out;
 
 	*dbm = vif_ctx_lnx->tx_power;
+out:
+	nrf_wifi_vif_cmd_end(vif_ctx_lnx);
 
-	vif_ctx_lnx->tx_power = 0;
-
-	return 0;
+	return status;
 }
 
 int nrf_wifi_cfg80211_get_channel(struct wiphy *wiphy,
@@ -2171,53 +2855,49 @@ int nrf_wifi_cfg80211_get_channel(struct wiphy *wiphy,
 {
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
-	unsigned int count = 50;
+	struct nrf_wifi_chan_definition *chan_def = NULL;
 	int status = 0;
 
 	vif_ctx_lnx = netdev_priv(wdev->netdev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+	chan_def = &vif_ctx_lnx->chan_def;
 
 	if (!(wdev->netdev->flags & IFF_UP)) {
 		pr_debug("%s: Interface is not UP\n", __func__);
 		return -ENETDOWN;
 	}
 
+	nrf_wifi_vif_cmd_begin(vif_ctx_lnx, NRF_WIFI_VIF_CMD_GET_CHANNEL);
+
 	status = nrf_wifi_fmac_get_channel(rpu_ctx_lnx->rpu_ctx,
 					   vif_ctx_lnx->if_idx);
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_get_channel failed\n", __func__);
-		return -EIO;
+		status = -EIO;
+		goto out;
 	}
 
 	pr_debug("%s: Waiting for response from RPU (Get Channel)\n", __func__);
 
-	while (!vif_ctx_lnx->chan_def && (count-- > 0))
-		msleep(100);
-
-	if (!vif_ctx_lnx->chan_def) {
-		status = -ETIMEDOUT;
-		pr_err("%s:Timed out waiting for response from RPU (Get Channel)\n",
-		       __func__);
+	status = nrf_wifi_vif_cmd_wait(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CMD_TIMEOUT_MS);
+	if (status)
 		goto out;
-	}
 
-	if (vif_ctx_lnx->chan_def->chan.center_frequency == 0) {
+	if (chan_def->chan.center_frequency == 0) {
 		status = -ENODATA;
 		goto out;
 	}
 
-	chandef->chan = ieee80211_get_channel(
-		wiphy, vif_ctx_lnx->chan_def->chan.center_frequency);
+	chandef->chan =
+		ieee80211_get_channel(wiphy, chan_def->chan.center_frequency);
 
-	chandef->width = vif_ctx_lnx->chan_def->width;
-	chandef->center_freq1 = vif_ctx_lnx->chan_def->center_frequency1;
-	chandef->center_freq2 = vif_ctx_lnx->chan_def->center_frequency2;
+	chandef->width = chan_def->width;
+	chandef->center_freq1 = chan_def->center_frequency1;
+	chandef->center_freq2 = chan_def->center_frequency2;
 
 out:
-	if (vif_ctx_lnx->chan_def) {
-		kfree(vif_ctx_lnx->chan_def);
-		vif_ctx_lnx->chan_def = NULL;
-	}
+	nrf_wifi_vif_cmd_end(vif_ctx_lnx);
 
 	return status;
 }
@@ -2262,6 +2942,355 @@ out:
 	return status;
 }
 
+void nrf_wifi_cqm_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	spin_lock_init(&vif_ctx_lnx->cqm_lock);
+	ewma_nrf_wifi_rssi_init(&vif_ctx_lnx->cqm_rssi_avg);
+}
+
+/* A new link does not inherit the signal history of the previous one */
+void nrf_wifi_cqm_reset(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	spin_lock_bh(&vif_ctx_lnx->cqm_lock);
+	ewma_nrf_wifi_rssi_init(&vif_ctx_lnx->cqm_rssi_avg);
+	vif_ctx_lnx->cqm_rssi_last = 0;
+	spin_unlock_bh(&vif_ctx_lnx->cqm_lock);
+}
+
+/* Called from the RX path with the signal, in dBm, of each frame from the
+ * AP. Crossings of the configured thresholds by the averaged signal are
+ * reported the same way mac80211 does, so userspace no longer has to
+ * poll get_station.
+ */
+void nrf_wifi_cqm_rssi(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx, s32 rssi)
+{
+	enum nl80211_cqm_rssi_threshold_event event =
+		NL80211_CQM_RSSI_THRESHOLD_EVENT_LOW;
+	bool notify = false;
+	s32 last = 0;
+	s32 avg = 0;
+
+	if (rssi >= 0 || !netif_carrier_ok(vif_ctx_lnx->netdev))
+		return;
+
+	spin_lock_bh(&vif_ctx_lnx->cqm_lock);
+
+	ewma_nrf_wifi_rssi_add(&vif_ctx_lnx->cqm_rssi_avg, -rssi);
+	avg = -(s32)ewma_nrf_wifi_rssi_read(&vif_ctx_lnx->cqm_rssi_avg);
+	last = vif_ctx_lnx->cqm_rssi_last;
+
+	if (vif_ctx_lnx->cqm_rssi_range) {
+		if (avg < vif_ctx_lnx->cqm_rssi_low &&
+		    (!last || last >= vif_ctx_lnx->cqm_rssi_low)) {
+			notify = true;
+		} else if (avg > vif_ctx_lnx->cqm_rssi_high &&
+			   (!last || last <= vif_ctx_lnx->cqm_rssi_high)) {
+			event = NL80211_CQM_RSSI_THRESHOLD_EVENT_HIGH;
+			notify = true;
+		}
+	} else if (vif_ctx_lnx->cqm_rssi_thold) {
+		if (avg < vif_ctx_lnx->cqm_rssi_thold &&
+		    (!last || avg < last - (s32)vif_ctx_lnx->cqm_rssi_hyst)) {
+			notify = true;
+		} else if (avg > vif_ctx_lnx->cqm_rssi_thold &&
+			   (!last ||
+			    avg > last + (s32)vif_ctx_lnx->cqm_rssi_hyst)) {
+			event = NL80211_CQM_RSSI_THRESHOLD_EVENT_HIGH;
+			notify = true;
+		}
+	}
+
+	if (notify) {
+		vif_ctx_lnx->cqm_rssi_last = avg;
+
+		if (event == NL80211_CQM_RSSI_THRESHOLD_EVENT_LOW)
+			vif_ctx_lnx->cqm_rssi_low_events++;
+		else
+			vif_ctx_lnx->cqm_rssi_high_events++;
+	}
+
+	spin_unlock_bh(&vif_ctx_lnx->cqm_lock);
+
+	/* cfg80211 may set the next range from within the notification */
+	if (notify)
+		cfg80211_cqm_rssi_notify(vif_ctx_lnx->netdev, event, avg,
+					 GFP_ATOMIC);
+}
+
+int nrf_wifi_cfg80211_set_cqm_rssi_config(struct wiphy *wiphy,
+					  struct net_device *dev,
+					  s32 rssi_thold, u32 rssi_hyst)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+
+	vif_ctx_lnx = netdev_priv(dev);
+
+	spin_lock_bh(&vif_ctx_lnx->cqm_lock);
+	vif_ctx_lnx->cqm_rssi_range = false;
+	vif_ctx_lnx->cqm_rssi_thold = rssi_thold;
+	vif_ctx_lnx->cqm_rssi_hyst = rssi_hyst;
+	vif_ctx_lnx->cqm_rssi_last = 0;
+	spin_unlock_bh(&vif_ctx_lnx->cqm_lock);
+
+	return 0;
+}
+
+int nrf_wifi_cfg80211_set_cqm_rssi_range(struct wiphy *wiphy,
+					 struct net_device *dev,
+					 s32 rssi_low, s32 rssi_high)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+
+	vif_ctx_lnx = netdev_priv(dev);
+
+	spin_lock_bh(&vif_ctx_lnx->cqm_lock);
+	/* A zero range turns the monitor off */
+	vif_ctx_lnx->cqm_rssi_range = rssi_low || rssi_high;
+	vif_ctx_lnx->cqm_rssi_low = rssi_low;
+	vif_ctx_lnx->cqm_rssi_high = rssi_high;
+	vif_ctx_lnx->cqm_rssi_thold = 0;
+	vif_ctx_lnx->cqm_rssi_last = 0;
+	spin_unlock_bh(&vif_ctx_lnx->cqm_lock);
+
+	return 0;
+}
+
+/* LTF going with a GI given alone, and the other way round */
+const u8 nrf_wifi_he_gi_ltf[] = {
+	[NL80211_RATE_INFO_HE_GI_0_8] = NL80211_RATE_INFO_HE_2XLTF,
+	[NL80211_RATE_INFO_HE_GI_1_6] = NL80211_RATE_INFO_HE_2XLTF,
+	[NL80211_RATE_INFO_HE_GI_3_2] = NL80211_RATE_INFO_HE_4XLTF,
+};
+
+const u8 nrf_wifi_he_ltf_gi[] = {
+	[NL80211_RATE_INFO_HE_1XLTF] = NL80211_RATE_INFO_HE_GI_0_8,
+	[NL80211_RATE_INFO_HE_2XLTF] = NL80211_RATE_INFO_HE_GI_0_8,
+	[NL80211_RATE_INFO_HE_4XLTF] = NL80211_RATE_INFO_HE_GI_3_2,
+};
+
+/* Returns the number of rates @mask enables in the band of @sband, the
+ * rate is returned in the RPU encoding if there is exactly one
+ */
+static unsigned int
+nrf_wifi_bitrate_mask_rate(struct ieee80211_supported_band *sband,
+			   const struct cfg80211_bitrate_mask *mask,
+			   unsigned char *rate_flag, int *rate)
+{
+	u32 legacy = mask->control[sband->band].legacy;
+	/* 1x1, only the first spatial stream is of interest */
+	u8 ht = mask->control[sband->band].ht_mcs[0];
+	u16 vht = mask->control[sband->band].vht_mcs[0];
+	u16 he = mask->control[sband->band].he_mcs[0];
+	unsigned int count = 0;
+	int bitrate = 0;
+
+	count = hweight32(legacy) + hweight8(ht) + hweight16(vht) +
+		hweight16(he);
+	if (count != 1)
+		return count;
+
+	if (legacy) {
+		bitrate = sband->bitrates[__ffs(legacy)].bitrate;
+		*rate_flag = RPU_TPUT_MODE_LEGACY;
+		/* In Mbps, except for 5.5 Mbps given as 55 */
+		*rate = bitrate == 55 ? bitrate : bitrate / 10;
+	} else if (ht) {
+		*rate_flag = RPU_TPUT_MODE_HT;
+		*rate = __ffs(ht);
+	} else if (vht) {
+		*rate_flag = RPU_TPUT_MODE_VHT;
+		*rate = __ffs(vht);
+	} else {
+		*rate_flag = RPU_TPUT_MODE_HE_SU;
+		*rate = __ffs(he);
+	}
+
+	return count;
+}
+
+/* Whether @mask enables all of the rates of the band of @sband, which is
+ * what nl80211 passes for a band the user gave no rates for
+ */
+static bool
+nrf_wifi_bitrate_mask_all(struct ieee80211_supported_band *sband,
+			  const struct ieee80211_sta_he_cap *he_cap,
+			  const struct cfg80211_bitrate_mask *mask)
+{
+	u32 legacy = BIT(sband->n_bitrates) - 1;
+	u8 ht = 0;
+	u16 vht = 0;
+	u16 he = 0;
+
+	if (sband->ht_cap.ht_supported)
+		ht = sband->ht_cap.mcs.rx_mask[0];
+
+	/* 1x1, only the first spatial stream is of interest */
+	if (sband->vht_cap.vht_supported) {
+		switch (le16_to_cpu(sband->vht_cap.vht_mcs.tx_mcs_map) & 0x3) {
+		case IEEE80211_VHT_MCS_SUPPORT_0_7:
+			vht = 0xff;
+			break;
+		case IEEE80211_VHT_MCS_SUPPORT_0_8:
+			vht = 0x1ff;
+			break;
+		case IEEE80211_VHT_MCS_SUPPORT_0_9:
+			vht = 0x3ff;
+			break;
+		}
+	}
+
+	if (he_cap) {
+		switch (le16_to_cpu(he_cap->he_mcs_nss_supp.tx_mcs_80) & 0x3) {
+		case IEEE80211_HE_MCS_SUPPORT_0_7:
+			he = 0xff;
+			break;
+		case IEEE80211_HE_MCS_SUPPORT_0_9:
+			he = 0x3ff;
+			break;
+		case IEEE80211_HE_MCS_SUPPORT_0_11:
+			he = 0xfff;
+			break;
+		}
+	}
+
+	return mask->control[sband->band].legacy == legacy &&
+	       mask->control[sband->band].ht_mcs[0] == ht &&
+	       mask->control[sband->band].vht_mcs[0] == vht &&
+	       mask->control[sband->band].he_mcs[0] == he;
+}
+
+/* The RPU has no rate masks, only a fixed rate for all of its traffic.
+ * A mask leaving a single rate in a band pins that rate, a mask of all
+ * the rates hands the rate back to the RPU rate control, and any other
+ * mask cannot be programmed. HE GI and LTF apply to all of the HE rates.
+ */
+int nrf_wifi_cfg80211_set_bitrate_mask(
+	struct wiphy *wiphy, struct net_device *netdev, const u8 *peer,
+	const struct cfg80211_bitrate_mask *mask)
+{
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct ieee80211_supported_band *sband = NULL;
+	const struct ieee80211_sta_he_cap *he_cap = NULL;
+	unsigned char rate_flag = RPU_TPUT_MODE_LEGACY;
+	unsigned char band_rate_flag = 0;
+	int rate = NRF_WIFI_TX_RATE_AUTO;
+	int band_rate = 0;
+	u8 he_gi = NRF_WIFI_HE_LTF_GI_UNSET;
+	u8 he_ltf = NRF_WIFI_HE_LTF_GI_UNSET;
+	bool he_ltf_gi_fixed = false;
+	unsigned int count = 0;
+	int band = 0;
+	int status = -1;
+
+	vif_ctx_lnx = netdev_priv(netdev);
+	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+
+	if (peer) {
+		pr_err("%s: Per station rates are not supported\n", __func__);
+		status = -EOPNOTSUPP;
+		goto out;
+	}
+
+	for (band = 0; band < NUM_NL80211_BANDS; band++) {
+		sband = wiphy->bands[band];
+		if (!sband)
+			continue;
+
+		he_cap = ieee80211_get_he_iftype_cap(
+			sband, netdev->ieee80211_ptr->iftype);
+
+		count = nrf_wifi_bitrate_mask_rate(sband, mask, &band_rate_flag,
+						   &band_rate);
+		if (count == 1) {
+			if (rate != NRF_WIFI_TX_RATE_AUTO) {
+				pr_err("%s: Fixed rate in more than one band\n",
+				       __func__);
+				status = -EINVAL;
+				goto out;
+			}
+
+			rate_flag = band_rate_flag;
+			rate = band_rate;
+		} else if (!nrf_wifi_bitrate_mask_all(sband, he_cap, mask)) {
+			pr_err("%s: Only one rate or all rates can be set\n",
+			       __func__);
+			status = -EOPNOTSUPP;
+			goto out;
+		}
+
+		/* Not initialised by nl80211 for bands without HE */
+		if (!he_cap)
+			continue;
+
+		if (mask->control[band].he_gi != NRF_WIFI_HE_LTF_GI_UNSET) {
+			if (he_gi != NRF_WIFI_HE_LTF_GI_UNSET &&
+			    he_gi != mask->control[band].he_gi)
+				goto mismatch;
+			he_gi = mask->control[band].he_gi;
+		}
+
+		if (mask->control[band].he_ltf != NRF_WIFI_HE_LTF_GI_UNSET) {
+			if (he_ltf != NRF_WIFI_HE_LTF_GI_UNSET &&
+			    he_ltf != mask->control[band].he_ltf)
+				goto mismatch;
+			he_ltf = mask->control[band].he_ltf;
+		}
+	}
+
+	if (rate != NRF_WIFI_TX_RATE_AUTO || rpu_ctx_lnx->tx_rate_fixed) {
+		status = nrf_wifi_fmac_set_tx_rate(rpu_ctx_lnx->rpu_ctx,
+						   rate_flag, rate);
+
+		if (status != NRF_WIFI_STATUS_SUCCESS) {
+			pr_err("%s: nrf_wifi_fmac_set_tx_rate failed\n",
+			       __func__);
+			goto out;
+		}
+
+		rpu_ctx_lnx->tx_rate_fixed = rate != NRF_WIFI_TX_RATE_AUTO;
+		rpu_ctx_lnx->tx_rate_flag = rate_flag;
+		rpu_ctx_lnx->tx_rate = rate;
+	}
+
+	if (he_gi == NRF_WIFI_HE_LTF_GI_UNSET &&
+	    he_ltf != NRF_WIFI_HE_LTF_GI_UNSET)
+		he_gi = nrf_wifi_he_ltf_gi[he_ltf];
+	else if (he_ltf == NRF_WIFI_HE_LTF_GI_UNSET &&
+		 he_gi != NRF_WIFI_HE_LTF_GI_UNSET)
+		he_ltf = nrf_wifi_he_gi_ltf[he_gi];
+
+	he_ltf_gi_fixed = he_gi != NRF_WIFI_HE_LTF_GI_UNSET;
+
+	if (he_ltf_gi_fixed || rpu_ctx_lnx->he_ltf_gi_fixed) {
+		if (!he_ltf_gi_fixed) {
+			he_ltf = rpu_ctx_lnx->conf_params.he_ltf;
+			he_gi = rpu_ctx_lnx->conf_params.he_gi;
+		}
+
+		status = nrf_wifi_fmac_conf_ltf_gi(rpu_ctx_lnx->rpu_ctx, he_ltf,
+						   he_gi, he_ltf_gi_fixed);
+
+		if (status != NRF_WIFI_STATUS_SUCCESS) {
+			pr_err("%s: nrf_wifi_fmac_conf_ltf_gi failed\n",
+			       __func__);
+			goto out;
+		}
+
+		rpu_ctx_lnx->he_ltf_gi_fixed = he_ltf_gi_fixed;
+		rpu_ctx_lnx->conf_params.he_ltf = he_ltf;
+		rpu_ctx_lnx->conf_params.he_gi = he_gi;
+	}
+
+	status = 0;
+	goto out;
+mismatch:
+	pr_err("%s: Different HE GI/LTF in different bands\n", __func__);
+	status = -EINVAL;
+out:
+	return status;
+}
+
 struct cfg80211_ops cfg80211_ops = {
 
 	.add_virtual_intf = nrf_wifi_cfg80211_add_vif,
@@ -2285,6 +3314,8 @@ struct cfg80211_ops cfg80211_ops = {
 	.set_txq_params = nrf_wifi_cfg80211_set_txq_params,
 
 	.scan = nrf_wifi_cfg80211_scan,
+	.sched_scan_start = nrf_wifi_cfg80211_sched_scan_start,
+	.sched_scan_stop = nrf_wifi_cfg80211_sched_scan_stop,
 	.auth = nrf_wifi_cfg80211_auth,
 	.assoc = nrf_wifi_cfg80211_assoc,
 	.deauth = nrf_wifi_cfg80211_deauth,
@@ -2309,6 +3340,9 @@ struct cfg80211_ops cfg80211_ops = {
 	.get_tx_power = nrf_wifi_cfg80211_get_tx_power,
 	.get_channel = nrf_wifi_cfg80211_get_channel,
 	.set_wiphy_params = nrf_wifi_cfg80211_set_wiphy_params,
+	.set_cqm_rssi_config = nrf_wifi_cfg80211_set_cqm_rssi_config,
+	.set_cqm_rssi_range_config = nrf_wifi_cfg80211_set_cqm_rssi_range,
+	.set_bitrate_mask = nrf_wifi_cfg80211_set_bitrate_mask,
 };
 #else /* CONFIG_NRF700X_RADIO_TEST */
 struct cfg80211_ops cfg80211_ops = {};
@@ -2438,7 +3472,17 @@ void wiphy_init(struct wiphy *wiphy)
 		BIT(NL80211_IFTYPE_P2P_GO) | BIT(NL80211_IFTYPE_P2P_CLIENT);
 
 	wiphy->max_scan_ssids = 4;
-	wiphy->max_scan_ie_len = IEEE80211_MAX_DATA_LEN;
+	wiphy->max_scan_ie_len = NRF_WIFI_MAX_IE_LEN;
+
+	wiphy->max_sched_scan_reqs = 1;
+	wiphy->max_sched_scan_ssids = NRF_WIFI_SCAN_MAX_NUM_SSIDS;
+	wiphy->max_match_sets = NRF_WIFI_SCHED_SCAN_MAX_MATCH_SETS;
+	wiphy->max_sched_scan_ie_len = NRF_WIFI_MAX_IE_LEN;
+	wiphy->max_sched_scan_plans = NRF_WIFI_SCHED_SCAN_MAX_PLANS;
+	wiphy->max_sched_scan_plan_interval =
+		NRF_WIFI_SCHED_SCAN_MAX_PLAN_INTERVAL;
+	wiphy->max_sched_scan_plan_iterations =
+		NRF_WIFI_SCHED_SCAN_MAX_PLAN_ITERATIONS;
 
 	wiphy->cipher_suites = cipher_suites;
 	wiphy->n_cipher_suites = ARRAY_SIZE(cipher_suites);
@@ -2469,6 +3513,7 @@ struct wiphy *cfg80211_if_init(void)
 
 	/* Below flag is required for passing duration by iw utilities */
 	wiphy_ext_feature_set(wiphy, NL80211_EXT_FEATURE_SET_SCAN_DWELL);
+	wiphy_ext_feature_set(wiphy, NL80211_EXT_FEATURE_CQM_RSSI_LIST);
 
 	wiphy_init(wiphy);
 
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+#ifndef CONFIG_NRF700X_RADIO_TEST
+#include <linux/hashtable.h>
+#include <linux/jiffies.h>
+#include <linux/spinlock.h>
+
+#include "main.h"
+
+/* Longer than any remain on channel or off channel TX wait */
+#define NRF_WIFI_COOKIE_EXPIRY_MS 30000
+
+void nrf_wifi_cookies_init(struct nrf_wifi_cookies *cookies)
+{
+	int i = 0;
+
+	spin_lock_init(&cookies->lock);
+	hash_init(cookies->hash);
+	INIT_LIST_HEAD(&cookies->used);
+	INIT_LIST_HEAD(&cookies->free);
+
+	for (i = 0; i < NRF_WIFI_COOKIE_SLAB_SIZE; i++)
+		list_add_tail(&cookies->slab[i].list, &cookies->free);
+}
+
+static void nrf_wifi_cookie_del(struct nrf_wifi_cookies *cookies,
+				struct cookie_info *cookie_info)
+{
+	hash_del(&cookie_info->node);
+	list_move(&cookie_info->list, &cookies->free);
+	cookies->count--;
+}
+
+static void nrf_wifi_cookies_expire(struct nrf_wifi_cookies *cookies)
+{
+	struct cookie_info *cookie_info = NULL;
+	struct cookie_info *tmp = NULL;
+	unsigned long expiry = msecs_to_jiffies(NRF_WIFI_COOKIE_EXPIRY_MS);
+
+	list_for_each_entry_safe(cookie_info, tmp, &cookies->used, list) {
+		if (time_before(jiffies, cookie_info->ts + expiry))
+			break;
+
+		pr_debug("%s: Dropping stale cookie %llu\n", __func__,
+			 cookie_info->rpu_cookie);
+		nrf_wifi_cookie_del(cookies, cookie_info);
+		cookies->expired++;
+	}
+}
+
+void nrf_wifi_cookie_add(struct nrf_wifi_cookies *cookies,
+			 unsigned long long host_cookie,
+			 unsigned long long rpu_cookie)
+{
+	struct cookie_info *cookie_info = NULL;
+
+	spin_lock_bh(&cookies->lock);
+
+	nrf_wifi_cookies_expire(cookies);
+
+	/* Make room by forgetting the oldest cookie */
+	if (list_empty(&cookies->free)) {
+		cookie_info = list_first_entry(&cookies->used,
+					       struct cookie_info, list);
+		nrf_wifi_cookie_del(cookies, cookie_info);
+		cookies->recycled++;
+	}
+
+	cookie_info = list_first_entry(&cookies->free, struct cookie_info,
+				       list);
+	cookie_info->host_cookie = host_cookie;
+	cookie_info->rpu_cookie = rpu_cookie;
+	cookie_info->ts = jiffies;
+
+	hash_add(cookies->hash, &cookie_info->node, rpu_cookie);
+	list_move_tail(&cookie_info->list, &cookies->used);
+	cookies->count++;
+	cookies->adds++;
+
+	spin_unlock_bh(&cookies->lock);
+}
+
+/* Looks up the host cookie of @rpu_cookie, @remove once the RPU is done
+ * with it
+ */
+bool nrf_wifi_cookie_get(struct nrf_wifi_cookies *cookies,
+			 unsigned long long rpu_cookie,
+			 unsigned long long *host_cookie, bool remove)
+{
+	struct cookie_info *cookie_info = NULL;
+	bool found = false;
+
+	spin_lock_bh(&cookies->lock);
+
+	hash_for_each_possible(cookies->hash, cookie_info, node, rpu_cookie) {
+		if (cookie_info->rpu_cookie != rpu_cookie)
+			continue;
+
+		*host_cookie = cookie_info->host_cookie;
+		found = true;
+
+		if (remove)
+			nrf_wifi_cookie_del(cookies, cookie_info);
+
+		break;
+	}
+
+	if (found)
+		cookies->hits++;
+	else
+		cookies->misses++;
+
+	spin_unlock_bh(&cookies->lock);
+
+	return found;
+}
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
@@ -12,6 +12,8 @@
 #include "fmac_dbgfs_if.h"
 
 extern struct nrf_wifi_drv_priv_lnx rpu_drv_priv;
+extern const u8 nrf_wifi_he_gi_ltf[];
+extern const u8 nrf_wifi_he_ltf_gi[];
 struct nrf_wifi_ctx_lnx *ctx;
 
 static __always_inline unsigned char
@@ -62,6 +64,8 @@ static __always_inline unsigned char param_get_match(unsigned char *buf,
 static int nrf_wifi_wlan_fmac_conf_disp(struct seq_file *m, void *v)
 {
 	struct rpu_conf_params *conf_params = NULL;
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+	int i = 0;
 
 	conf_params = &ctx->conf_params;
 
@@ -70,9 +74,25 @@ static int nrf_wifi_wlan_fmac_conf_disp(struct seq_file *m, void *v)
 	seq_printf(m, "uapsd_queue = %d\n", conf_params->uapsd_queue);
 	seq_printf(m, "power_save = %s\n",
 		   conf_params->power_save ? "ON" : "OFF");
+	seq_printf(m, "he_ltf = %d\n", conf_params->he_ltf);
 	seq_printf(m, "he_gi = %d\n", conf_params->he_gi);
+	seq_printf(m, "he_ltf_gi = %s\n",
+		   ctx->he_ltf_gi_fixed ? "fixed" : "auto");
+	if (ctx->tx_rate_fixed)
+		seq_printf(m, "tx_rate = %d (rate_flag %d)\n", ctx->tx_rate,
+			   ctx->tx_rate_flag);
+	else
+		seq_puts(m, "tx_rate = auto\n");
 	seq_printf(m, "rts_threshold = %d\n", conf_params->rts_threshold);
 
+	nrf_wifi_rx_pools_get(pools);
+
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++) {
+		seq_printf(m, "rx%d_num_bufs = %u\n", i + 1,
+			   pools[i].num_bufs);
+		seq_printf(m, "rx%d_buf_sz = %u\n", i + 1, pools[i].buf_sz);
+	}
+
 	return 0;
 }
 
@@ -157,6 +177,30 @@ static ssize_t nrf_wifi_wlan_fmac_conf_write(struct file *file,
 			goto error;
 		}
 		ctx->conf_params.power_save = val;
+	} else if (param_get_val(conf_buf, "he_ltf=", &val)) {
+		if ((val < 0) || (val > 2)) {
+			snprintf(err_str, MAX_ERR_STR_SIZE,
+				 "Invalid value %lu\n", val);
+			err_val = -EINVAL;
+			goto error;
+		}
+
+		if (ctx->he_ltf_gi_fixed && ctx->conf_params.he_ltf == val &&
+		    ctx->conf_params.he_gi == nrf_wifi_he_ltf_gi[val])
+			goto out;
+
+		/* Paired as in nrf_wifi_cfg80211_set_bitrate_mask() */
+		status = nrf_wifi_fmac_conf_ltf_gi(ctx->rpu_ctx, val,
+						   nrf_wifi_he_ltf_gi[val], 1);
+
+		if (status != NRF_WIFI_STATUS_SUCCESS) {
+			snprintf(err_str, MAX_ERR_STR_SIZE,
+				 "Programming he_ltf failed\n");
+			goto error;
+		}
+		ctx->conf_params.he_ltf = val;
+		ctx->conf_params.he_gi = nrf_wifi_he_ltf_gi[val];
+		ctx->he_ltf_gi_fixed = true;
 	} else if (param_get_val(conf_buf, "he_gi=", &val)) {
 		if ((val < 0) || (val > 2)) {
 			snprintf(err_str, MAX_ERR_STR_SIZE,
@@ -165,9 +209,23 @@ static ssize_t nrf_wifi_wlan_fmac_conf_write(struct file *file,
 			goto error;
 		}
 
-		if (ctx->conf_params.he_gi == val)
+		if (ctx->he_ltf_gi_fixed && ctx->conf_params.he_gi == val &&
+		    ctx->conf_params.he_ltf == nrf_wifi_he_gi_ltf[val])
 			goto out;
+
+		/* Paired as in nrf_wifi_cfg80211_set_bitrate_mask() */
+		status = nrf_wifi_fmac_conf_ltf_gi(ctx->rpu_ctx,
+						   nrf_wifi_he_gi_ltf[val], val,
+						   1);
+
+		if (status != NRF_WIFI_STATUS_SUCCESS) {
+			snprintf(err_str, MAX_ERR_STR_SIZE,
+				 "Programming he_gi failed\n");
+			goto error;
+		}
+		ctx->conf_params.he_ltf = nrf_wifi_he_gi_ltf[val];
 		ctx->conf_params.he_gi = val;
+		ctx->he_ltf_gi_fixed = true;
 	} else if (param_get_val(conf_buf, "rts_threshold=", &val)) {
 		struct nrf_wifi_umac_set_wiphy_info *wiphy_info = NULL;
 
@@ -304,6 +362,12 @@ int nrf_wifi_wlan_fmac_dbgfs_init(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
 	if (status != NRF_WIFI_STATUS_SUCCESS)
 		goto out;
 
+	status = nrf_wifi_wlan_fmac_dbgfs_pktram_init(
+		rpu_ctx_lnx->dbgfs_wlan_root, rpu_ctx_lnx);
+
+	if (status != NRF_WIFI_STATUS_SUCCESS)
+		goto out;
+
 out:
 	if (status != NRF_WIFI_STATUS_SUCCESS)
 		nrf_wifi_wlan_fmac_dbgfs_deinit(rpu_ctx_lnx);
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+#include <linux/debugfs.h>
+
+#include "fmac_api.h"
+#include "fmac_util.h"
+#include "fmac_dbgfs_if.h"
+
+extern unsigned int pktram_policy;
+extern unsigned int pktram_hold;
+
+static const char *const nrf_wifi_pktram_policy_str[] = {
+	[NRF_WIFI_PKTRAM_POLICY_STATIC] = "static",
+	[NRF_WIFI_PKTRAM_POLICY_RX] = "rx",
+	[NRF_WIFI_PKTRAM_POLICY_TX] = "tx",
+	[NRF_WIFI_PKTRAM_POLICY_AUTO] = "auto",
+};
+
+static const char *const nrf_wifi_pktram_dir_str[] = {
+	[NRF_WIFI_PKTRAM_DIR_NONE] = "none",
+	[NRF_WIFI_PKTRAM_DIR_RX] = "rx",
+	[NRF_WIFI_PKTRAM_DIR_TX] = "tx",
+};
+
+static int nrf_wifi_wlan_fmac_dbgfs_pktram_show(struct seq_file *m, void *v)
+{
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
+	struct nrf_wifi_pktram *pktram = NULL;
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+#ifdef CONFIG_NRF700X_DATA_TX
+	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
+	struct nrf_wifi_fmac_priv_def *def_priv = NULL;
+#endif /* CONFIG_NRF700X_DATA_TX */
+	unsigned int policy = READ_ONCE(pktram_policy);
+	unsigned int rx_size = 0;
+
+	rpu_ctx_lnx = (struct nrf_wifi_ctx_lnx *)m->private;
+	pktram = &rpu_ctx_lnx->pktram;
+
+	nrf_wifi_rx_pools_get(pools);
+	rx_size = nrf_wifi_rx_pools_size(pools);
+
+	seq_puts(m, "************* PKTRAM SPLIT ***********\n");
+	seq_printf(m, "pktram_size = %u\n", RPU_PKTRAM_SIZE);
+	seq_printf(m, "rx_bufs_size = %u\n", rx_size);
+	seq_printf(m, "tx_tokens_size = %u\n", RPU_PKTRAM_SIZE - rx_size);
+	seq_printf(m, "tx_tokens = %d\n", CONFIG_NRF700X_MAX_TX_TOKENS);
+#ifdef CONFIG_NRF700X_DATA_TX
+	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
+	def_priv = wifi_fmac_priv(fmac_dev_ctx->fpriv);
+	seq_printf(m, "max_ampdu_len_per_token = %u\n",
+		   def_priv->max_ampdu_len_per_token);
+	seq_printf(m, "avail_ampdu_len_per_token = %u\n",
+		   def_priv->avail_ampdu_len_per_token);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	seq_printf(m, "policy = %s\n",
+		   policy < NRF_WIFI_PKTRAM_POLICY_MAX ?
+			   nrf_wifi_pktram_policy_str[policy] :
+			   "static");
+	seq_printf(m, "traffic_dir = %s\n",
+		   nrf_wifi_pktram_dir_str[pktram->dir]);
+	seq_printf(m, "traffic_dir_hold = %u / %u\n", pktram->hold,
+		   READ_ONCE(pktram_hold));
+
+	if (nrf_wifi_pktram_target(nrf_wifi_pktram_target_dir(rpu_ctx_lnx),
+				   pools)) {
+		seq_printf(m, "target_rx_bufs_size = %u\n",
+			   nrf_wifi_rx_pools_size(pools));
+		seq_printf(m, "target_rx_num_bufs = %u/%u/%u\n",
+			   pools[0].num_bufs, pools[1].num_bufs,
+			   pools[2].num_bufs);
+	} else {
+		seq_puts(m, "target_rx_bufs_size = none\n");
+	}
+
+	seq_printf(m, "reload_recommended = %s\n",
+		   pktram->pending ? "yes" : "no");
+
+	return 0;
+}
+
+static int open_pktram(struct inode *inode, struct file *file)
+{
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx =
+		(struct nrf_wifi_ctx_lnx *)inode->i_private;
+
+	return single_open(file, nrf_wifi_wlan_fmac_dbgfs_pktram_show,
+			   rpu_ctx_lnx);
+}
+
+static const struct file_operations fops_pktram = { .open = open_pktram,
+						    .read = seq_read,
+						    .llseek = seq_lseek,
+						    .write = NULL,
+						    .release = single_release };
+
+int nrf_wifi_wlan_fmac_dbgfs_pktram_init(struct dentry *root,
+					 struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
+{
+	if ((!root) || (!rpu_ctx_lnx)) {
+		pr_err("%s: Invalid parameters\n", __func__);
+		return -EINVAL;
+	}
+
+	/* Removed along with the wlan root */
+	if (!debugfs_create_file("pktram", 0444, root, rpu_ctx_lnx,
+				 &fops_pktram)) {
+		pr_err("%s: Failed to create debugfs entry\n", __func__);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
@@ -7,7 +7,11 @@
 #include <linux/debugfs.h>
 
 #include "fmac_api.h"
+#include "fmac_util.h"
 #include "fmac_dbgfs_if.h"
+#include "net_stack.h"
+
+extern struct nrf_wifi_drv_priv_lnx rpu_drv_priv;
 
 #ifndef CONFIG_NRF700X_RADIO_TEST
 static void nrf_wifi_wlan_fmac_dbgfs_stats_show_host(
@@ -52,6 +56,158 @@ static void nrf_wifi_wlan_fmac_dbgfs_stats_show_host(
 #endif /* DEBUG_MODE_SUPPORT */
 }
 
+#ifdef CONFIG_NRF700X_DATA_TX
+static void nrf_wifi_wlan_fmac_dbgfs_stats_show_tx(
+	struct seq_file *m, struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx)
+{
+	struct nrf_wifi_netdev_pcpu_stats pcpu_sum;
+
+	nrf_wifi_netdev_stats_read(vif_ctx, &pcpu_sum);
+
+	seq_puts(m, "************* DRIVER TX STATS ***********\n");
+	seq_printf(m, "tx_inflight = %d\n", atomic_read(&vif_ctx->tx_inflight));
+	seq_printf(m, "tx_credits = %d\n", vif_ctx->tx_credits);
+	seq_printf(m, "tx_queue_stops = %llu\n", pcpu_sum.tx_queue_stops);
+	seq_printf(m, "tx_queue_wakes = %llu\n", pcpu_sum.tx_queue_wakes);
+	seq_printf(m, "tx_credit_stalls = %llu\n", pcpu_sum.tx_credit_stalls);
+	seq_printf(m, "tx_stopped_us = %llu\n",
+		   div_u64(pcpu_sum.tx_stopped_ns, NSEC_PER_USEC));
+	seq_printf(m, "tx_fq_backlog = %u\n", vif_ctx->tx_fq.backlog);
+	seq_printf(m, "tx_fq_overlimit = %u\n", vif_ctx->tx_fq.overlimit);
+	seq_printf(m, "tx_fq_overmemory = %u\n", vif_ctx->tx_fq.overmemory);
+	seq_printf(m, "tx_fq_collisions = %u\n", vif_ctx->tx_fq.collisions);
+	seq_printf(m, "tx_codel_drops = %u\n", vif_ctx->tx_cstats.drop_count);
+	seq_printf(m, "tx_codel_ecn_marks = %u\n",
+		   vif_ctx->tx_cstats.ecn_mark);
+	seq_printf(m, "tx_credit_depth = %u\n", vif_ctx->tx_credit_depth);
+	seq_printf(m, "tx_credit_raises = %llu\n", vif_ctx->tx_credit_raises);
+	seq_printf(m, "tx_credit_lowers = %llu\n", vif_ctx->tx_credit_lowers);
+	seq_printf(m, "tx_fast_pkts = %llu\n", pcpu_sum.tx_fast_pkts);
+	seq_printf(m, "tx_deferred_pkts = %llu\n", pcpu_sum.tx_deferred_pkts);
+}
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+static void nrf_wifi_wlan_fmac_dbgfs_stats_show_scan(
+	struct seq_file *m, struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx)
+{
+	seq_puts(m, "************* DRIVER SCAN STATS ***********\n");
+	seq_printf(m, "scans = %llu\n", vif_ctx->scans);
+	seq_printf(m, "scans_aborted = %llu\n", vif_ctx->scans_aborted);
+	seq_printf(m, "scan_last_us = %u\n", vif_ctx->scan_last_us);
+	seq_printf(m, "scan_min_us = %u\n", vif_ctx->scan_min_us);
+	seq_printf(m, "scan_max_us = %u\n", vif_ctx->scan_max_us);
+	seq_printf(m, "scan_avg_us = %llu\n",
+		   vif_ctx->scans ?
+			   div64_u64(vif_ctx->scan_total_us, vif_ctx->scans) :
+			   0);
+	seq_printf(m, "sched_scans = %llu\n", vif_ctx->sched_scans);
+	seq_printf(m, "sched_scan_matches = %llu\n",
+		   vif_ctx->sched_scan_matches);
+	seq_printf(m, "bss_informed = %llu\n", vif_ctx->bss_informed);
+	seq_printf(m, "bss_merged = %llu\n", vif_ctx->bss_merged);
+	seq_printf(m, "bss_table_full = %llu\n", vif_ctx->bss_table_full);
+
+	seq_puts(m, "************* DRIVER CONNECT STATS ***********\n");
+	seq_printf(m, "connects = %llu\n", vif_ctx->connects);
+	seq_printf(m, "roams = %llu\n", vif_ctx->roams);
+	seq_printf(m, "connect_last_us = %u\n", vif_ctx->connect_last_us);
+	seq_printf(m, "connect_min_us = %u\n", vif_ctx->connect_min_us);
+	seq_printf(m, "connect_max_us = %u\n", vif_ctx->connect_max_us);
+
+	seq_puts(m, "************* DRIVER CQM STATS ***********\n");
+	seq_printf(m, "cqm_rssi_avg = %d dBm\n",
+		   -(int)ewma_nrf_wifi_rssi_read(&vif_ctx->cqm_rssi_avg));
+	seq_printf(m, "cqm_rssi_low_events = %llu\n",
+		   vif_ctx->cqm_rssi_low_events);
+	seq_printf(m, "cqm_rssi_high_events = %llu\n",
+		   vif_ctx->cqm_rssi_high_events);
+}
+
+static const char *const nrf_wifi_wmm_ac_str[] = {
+	[NL80211_AC_VO] = "VO",
+	[NL80211_AC_VI] = "VI",
+	[NL80211_AC_BE] = "BE",
+	[NL80211_AC_BK] = "BK",
+};
+
+static void
+nrf_wifi_wlan_fmac_dbgfs_stats_show_wmm(struct seq_file *m,
+					struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
+{
+	struct nrf_wifi_fmac_dev_ctx_def *def_dev_ctx = NULL;
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct ieee80211_txq_params *params = NULL;
+	unsigned char i = 0;
+	int ac = 0;
+
+	def_dev_ctx = wifi_dev_priv(rpu_ctx_lnx->rpu_ctx);
+
+	seq_puts(m, "************* DRIVER WMM PARAMS ***********\n");
+
+	for (i = 0; i < MAX_NUM_VIFS; i++) {
+		if (!def_dev_ctx->vif_ctx[i])
+			continue;
+
+		vif_ctx_lnx = def_dev_ctx->vif_ctx[i]->os_vif_ctx;
+		if (!vif_ctx_lnx || !vif_ctx_lnx->wmm_params_set)
+			continue;
+
+		seq_printf(m, "%s:\n", netdev_name(vif_ctx_lnx->netdev));
+
+		for (ac = 0; ac < NL80211_NUM_ACS; ac++) {
+			if (!test_bit(ac, &vif_ctx_lnx->wmm_params_set))
+				continue;
+
+			params = &vif_ctx_lnx->wmm_params[ac];
+			seq_printf(m,
+				   "%s: aifs %u, cwmin %u, cwmax %u, txop %u\n",
+				   nrf_wifi_wmm_ac_str[ac], params->aifs,
+				   params->cwmin, params->cwmax, params->txop);
+		}
+	}
+}
+
+static void nrf_wifi_wlan_fmac_dbgfs_stats_show_rx_pools(struct seq_file *m)
+{
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+	struct nrf_wifi_rx_pool_stats *pool_stats = NULL;
+	int i = 0;
+
+	nrf_wifi_rx_pools_get(pools);
+
+	seq_puts(m, "************* DRIVER RX POOL STATS ***********\n");
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++) {
+		pool_stats = &rpu_drv_priv.rx_pool_stats[i];
+
+		seq_printf(m, "rx%d_num_bufs = %u\n", i + 1,
+			   pools[i].num_bufs);
+		seq_printf(m, "rx%d_buf_sz = %u\n", i + 1, pools[i].buf_sz);
+		seq_printf(m, "rx%d_posted = %u\n", i + 1, pool_stats->posted);
+		seq_printf(m, "rx%d_min_posted = %u\n", i + 1,
+			   pool_stats->min_posted);
+		seq_printf(m, "rx%d_starved = %llu\n", i + 1,
+			   pool_stats->starved);
+		seq_printf(m, "rx%d_samples = %llu\n", i + 1,
+			   pool_stats->samples);
+	}
+}
+
+static void
+nrf_wifi_wlan_fmac_dbgfs_stats_show_cookies(struct seq_file *m,
+					    struct nrf_wifi_cookies *cookies)
+{
+	seq_puts(m, "************* DRIVER COOKIE STATS ***********\n");
+	spin_lock_bh(&cookies->lock);
+	seq_printf(m, "cookies_in_use = %u / %d\n", cookies->count,
+		   NRF_WIFI_COOKIE_SLAB_SIZE);
+	seq_printf(m, "cookie_adds = %llu\n", cookies->adds);
+	seq_printf(m, "cookie_hits = %llu\n", cookies->hits);
+	seq_printf(m, "cookie_misses = %llu\n", cookies->misses);
+	seq_printf(m, "cookie_expired = %llu\n", cookies->expired);
+	seq_printf(m, "cookie_recycled = %llu\n", cookies->recycled);
+	spin_unlock_bh(&cookies->lock);
+}
+
 static void
 nrf_wifi_wlan_fmac_dbgfs_stats_show_umac(struct seq_file *m,
 					 struct rpu_umac_stats *stats)
@@ -517,6 +673,21 @@ static int nrf_wifi_wlan_fmac_dbgfs_stats_show(struct seq_file *m, void *v)
 	op_mode = rpu_ctx_lnx->conf_params.op_mode,
 #endif
 
+#ifdef CONFIG_NRF700X_DATA_TX
+	/* Host side only, shown even if the RPU does not answer */
+	if (rpu_ctx_lnx->def_vif_ctx)
+		nrf_wifi_wlan_fmac_dbgfs_stats_show_tx(
+			m, rpu_ctx_lnx->def_vif_ctx);
+#endif /* CONFIG_NRF700X_DATA_TX */
+#ifndef CONFIG_NRF700X_RADIO_TEST
+	if (rpu_ctx_lnx->def_vif_ctx)
+		nrf_wifi_wlan_fmac_dbgfs_stats_show_scan(
+			m, rpu_ctx_lnx->def_vif_ctx);
+	nrf_wifi_wlan_fmac_dbgfs_stats_show_wmm(m, rpu_ctx_lnx);
+	nrf_wifi_wlan_fmac_dbgfs_stats_show_rx_pools(m);
+	nrf_wifi_wlan_fmac_dbgfs_stats_show_cookies(m, &rpu_ctx_lnx->cookies);
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
+
 	stats = kzalloc(sizeof(*stats), GFP_KERNEL);
 
 	status = nrf_wifi_fmac_stats_get(rpu_ctx_lnx->rpu_ctx,
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+#ifndef CONFIG_NRF700X_RADIO_TEST
+#include <linux/ethtool.h>
+#include <linux/netdevice.h>
+
+#include "main.h"
+#include "fmac_main.h"
+#include "fmac_api.h"
+#include "net_stack.h"
+
+extern struct nrf_wifi_drv_priv_lnx rpu_drv_priv;
+
+#ifdef CONFIG_NRF700X_DATA_TX
+#define NRF_WIFI_ETHTOOL_TX_QLEN_MAX 1024
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+struct nrf_wifi_ethtool_stat {
+	char name[ETH_GSTRING_LEN];
+	size_t offset;
+};
+
+#define NRF_WIFI_DRV_STAT(_field)                                              \
+	{                                                                      \
+		#_field, offsetof(struct nrf_wifi_netdev_pcpu_stats, _field)   \
+	}
+
+static const struct nrf_wifi_ethtool_stat nrf_wifi_drv_stats[] = {
+	NRF_WIFI_DRV_STAT(rx_packets),
+	NRF_WIFI_DRV_STAT(rx_bytes),
+	NRF_WIFI_DRV_STAT(rx_dropped),
+	NRF_WIFI_DRV_STAT(rx_multicast),
+	NRF_WIFI_DRV_STAT(rx_mc_filtered),
+	NRF_WIFI_DRV_STAT(tx_packets),
+	NRF_WIFI_DRV_STAT(tx_bytes),
+	NRF_WIFI_DRV_STAT(tx_dropped),
+	NRF_WIFI_DRV_STAT(tx_errors),
+	NRF_WIFI_DRV_STAT(tx_fast_pkts),
+	NRF_WIFI_DRV_STAT(tx_deferred_pkts),
+	NRF_WIFI_DRV_STAT(rx_xdp_drop),
+	NRF_WIFI_DRV_STAT(rx_xdp_tx),
+	NRF_WIFI_DRV_STAT(rx_xdp_redirect),
+};
+
+static const char nrf_wifi_mc_stats[][ETH_GSTRING_LEN] = {
+	"mc_add_cmds",
+	"mc_del_cmds",
+};
+
+static const char nrf_wifi_sta_cache_stats[][ETH_GSTRING_LEN] = {
+	"sta_cache_hits",
+	"sta_cache_misses",
+};
+
+/* Per RX pool: bufs, posted, min_posted, starved */
+#define NRF_WIFI_RX_POOL_STATS (4 * MAX_NUM_OF_RX_QUEUES)
+
+#ifdef CONFIG_NRF700X_DATA_TX
+static const char nrf_wifi_tx_stats[][ETH_GSTRING_LEN] = {
+	"tx_queue_stops",
+	"tx_queue_wakes",
+	"tx_credit_stalls",
+	"tx_inflight",
+	"tx_fq_backlog",
+	"tx_fq_overlimit",
+	"tx_fq_overmemory",
+	"tx_fq_collisions",
+	"tx_codel_drops",
+	"tx_codel_ecn_marks",
+	"tx_credit_depth",
+	"tx_credit_raises",
+	"tx_credit_lowers",
+};
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+static int nrf_wifi_ethtool_stats_count(void)
+{
+	int count = ARRAY_SIZE(nrf_wifi_drv_stats);
+
+#ifdef CONFIG_NRF700X_DATA_TX
+	count += ARRAY_SIZE(nrf_wifi_tx_stats);
+#endif /* CONFIG_NRF700X_DATA_TX */
+	count += ARRAY_SIZE(nrf_wifi_mc_stats);
+	count += ARRAY_SIZE(nrf_wifi_sta_cache_stats);
+	count += NRF_WIFI_RX_POOL_STATS;
+
+	return count;
+}
+
+static void nrf_wifi_ethtool_get_drvinfo(struct net_device *netdev,
+					 struct ethtool_drvinfo *info)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+	enum nrf_wifi_status status = NRF_WIFI_STATUS_FAIL;
+	unsigned int fw_ver = 0;
+
+	strscpy(info->driver, KBUILD_MODNAME, sizeof(info->driver));
+	strscpy(info->version, NRF_WIFI_FMAC_DRV_VER, sizeof(info->version));
+
+	status = nrf_wifi_fmac_ver_get(rpu_ctx_lnx->rpu_ctx, &fw_ver);
+	if (status == NRF_WIFI_STATUS_SUCCESS)
+		snprintf(info->fw_version, sizeof(info->fw_version),
+			 "%d.%d.%d.%d", NRF_WIFI_UMAC_VER(fw_ver),
+			 NRF_WIFI_UMAC_VER_MAJ(fw_ver),
+			 NRF_WIFI_UMAC_VER_MIN(fw_ver),
+			 NRF_WIFI_UMAC_VER_EXTRA(fw_ver));
+
+	if (netdev->dev.parent)
+		strscpy(info->bus_info, dev_name(netdev->dev.parent),
+			sizeof(info->bus_info));
+}
+
+static int nrf_wifi_ethtool_get_sset_count(struct net_device *netdev,
+					   int sset)
+{
+	if (sset != ETH_SS_STATS)
+		return -EOPNOTSUPP;
+
+	return nrf_wifi_ethtool_stats_count();
+}
+
+static void nrf_wifi_ethtool_get_strings(struct net_device *netdev,
+					 u32 sset, u8 *data)
+{
+	int i = 0;
+
+	if (sset != ETH_SS_STATS)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(nrf_wifi_drv_stats); i++)
+		ethtool_sprintf(&data, "%s", nrf_wifi_drv_stats[i].name);
+
+#ifdef CONFIG_NRF700X_DATA_TX
+	for (i = 0; i < ARRAY_SIZE(nrf_wifi_tx_stats); i++)
+		ethtool_sprintf(&data, "%s", nrf_wifi_tx_stats[i]);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	for (i = 0; i < ARRAY_SIZE(nrf_wifi_mc_stats); i++)
+		ethtool_sprintf(&data, "%s", nrf_wifi_mc_stats[i]);
+
+	for (i = 0; i < ARRAY_SIZE(nrf_wifi_sta_cache_stats); i++)
+		ethtool_sprintf(&data, "%s", nrf_wifi_sta_cache_stats[i]);
+
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++) {
+		ethtool_sprintf(&data, "rx_pool%d_bufs", i + 1);
+		ethtool_sprintf(&data, "rx_pool%d_posted", i + 1);
+		ethtool_sprintf(&data, "rx_pool%d_min_posted", i + 1);
+		ethtool_sprintf(&data, "rx_pool%d_starved", i + 1);
+	}
+}
+
+/* Host side counters only, the RPU ones stay in debugfs stats as reading
+ * them is a firmware round trip that would wake the RPU on every poll.
+ */
+static void nrf_wifi_ethtool_get_stats(struct net_device *netdev,
+				       struct ethtool_stats *estats, u64 *data)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	struct nrf_wifi_netdev_pcpu_stats drv_stats;
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+	struct nrf_wifi_rx_pool_stats *pool_stats = NULL;
+	int i = 0;
+
+	memset(data, 0, nrf_wifi_ethtool_stats_count() * sizeof(*data));
+
+	nrf_wifi_netdev_stats_read(vif_ctx_lnx, &drv_stats);
+
+	for (i = 0; i < ARRAY_SIZE(nrf_wifi_drv_stats); i++)
+		*data++ = *(u64 *)((char *)&drv_stats +
+				   nrf_wifi_drv_stats[i].offset);
+
+#ifdef CONFIG_NRF700X_DATA_TX
+	*data++ = drv_stats.tx_queue_stops;
+	*data++ = drv_stats.tx_queue_wakes;
+	*data++ = drv_stats.tx_credit_stalls;
+	*data++ = atomic_read(&vif_ctx_lnx->tx_inflight);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_fq.backlog);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_fq.overlimit);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_fq.overmemory);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_fq.collisions);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_cstats.drop_count);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_cstats.ecn_mark);
+	*data++ = READ_ONCE(vif_ctx_lnx->tx_credit_depth);
+	*data++ = vif_ctx_lnx->tx_credit_raises;
+	*data++ = vif_ctx_lnx->tx_credit_lowers;
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	*data++ = vif_ctx_lnx->mc_add_cmds;
+	*data++ = vif_ctx_lnx->mc_del_cmds;
+	*data++ = READ_ONCE(vif_ctx_lnx->sta_cache_hits);
+	*data++ = READ_ONCE(vif_ctx_lnx->sta_cache_misses);
+
+	nrf_wifi_rx_pools_get(pools);
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++) {
+		pool_stats = &rpu_drv_priv.rx_pool_stats[i];
+		*data++ = pools[i].num_bufs;
+		*data++ = READ_ONCE(pool_stats->posted);
+		*data++ = READ_ONCE(pool_stats->min_posted);
+		*data++ = READ_ONCE(pool_stats->starved);
+	}
+}
+
+static unsigned int
+nrf_wifi_ethtool_rx_bufs(const struct rx_buf_pool_params *pools)
+{
+	unsigned int num_bufs = 0;
+	int i = 0;
+
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++)
+		num_bufs += pools[i].num_bufs;
+
+	return num_bufs;
+}
+
+static void nrf_wifi_ethtool_get_ringparam(struct net_device *netdev,
+					   struct ethtool_ringparam *ring)
+{
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+#ifdef CONFIG_NRF700X_DATA_TX
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+
+	ring->tx_max_pending = NRF_WIFI_ETHTOOL_TX_QLEN_MAX;
+	ring->tx_pending = READ_ONCE(vif_ctx_lnx->tx_qlen);
+#endif /* CONFIG_NRF700X_DATA_TX */
+	nrf_wifi_rx_pools_get(pools);
+	/* The RX buffers are handed to the RPU at firmware init */
+	ring->rx_max_pending = nrf_wifi_ethtool_rx_bufs(pools);
+	ring->rx_pending = ring->rx_max_pending;
+}
+
+static int nrf_wifi_ethtool_set_ringparam(struct net_device *netdev,
+					  struct ethtool_ringparam *ring)
+{
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+#ifdef CONFIG_NRF700X_DATA_TX
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	if (ring->rx_mini_pending || ring->rx_jumbo_pending)
+		return -EINVAL;
+
+	/* The RX pools are handed to the RPU at firmware init. A request
+	 * also changing them is refused as a whole, leaving tx_qlen as is.
+	 */
+	nrf_wifi_rx_pools_get(pools);
+	if (ring->rx_pending != nrf_wifi_ethtool_rx_bufs(pools))
+		return -EOPNOTSUPP;
+
+#ifdef CONFIG_NRF700X_DATA_TX
+	if (!ring->tx_pending ||
+	    ring->tx_pending > NRF_WIFI_ETHTOOL_TX_QLEN_MAX)
+		return -EINVAL;
+
+	/* Picked up by the next frame queued to the fair queue */
+	WRITE_ONCE(vif_ctx_lnx->tx_qlen, ring->tx_pending);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	return 0;
+}
+
+static int nrf_wifi_ethtool_get_coalesce(struct net_device *netdev,
+					 struct ethtool_coalesce *ec,
+					 struct kernel_ethtool_coalesce *kec,
+					 struct netlink_ext_ack *extack)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+
+	ec->rx_max_coalesced_frames = READ_ONCE(vif_ctx_lnx->napi.weight);
+#ifdef CONFIG_NRF700X_DATA_TX
+	ec->tx_max_coalesced_frames = READ_ONCE(vif_ctx_lnx->tx_budget);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	return 0;
+}
+
+static int nrf_wifi_ethtool_set_coalesce(struct net_device *netdev,
+					 struct ethtool_coalesce *ec,
+					 struct kernel_ethtool_coalesce *kec,
+					 struct netlink_ext_ack *extack)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+
+	if (!ec->rx_max_coalesced_frames ||
+	    ec->rx_max_coalesced_frames > NAPI_POLL_WEIGHT) {
+		NL_SET_ERR_MSG_MOD(extack, "rx-frames must be 1..64");
+		return -EINVAL;
+	}
+
+#ifdef CONFIG_NRF700X_DATA_TX
+	if (!ec->tx_max_coalesced_frames) {
+		NL_SET_ERR_MSG_MOD(extack, "tx-frames must be non-zero");
+		return -EINVAL;
+	}
+
+	/* Picked up by the next TX work run of this interface only */
+	WRITE_ONCE(vif_ctx_lnx->tx_budget, ec->tx_max_coalesced_frames);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	/* Frames per NAPI poll, picked up by the next poll */
+	WRITE_ONCE(vif_ctx_lnx->napi.weight, ec->rx_max_coalesced_frames);
+
+	return 0;
+}
+
+const struct ethtool_ops nrf_wifi_ethtool_ops = {
+	.supported_coalesce_params = ETHTOOL_COALESCE_MAX_FRAMES,
+	.get_drvinfo = nrf_wifi_ethtool_get_drvinfo,
+	.get_link = ethtool_op_get_link,
+	.get_sset_count = nrf_wifi_ethtool_get_sset_count,
+	.get_strings = nrf_wifi_ethtool_get_strings,
+	.get_ethtool_stats = nrf_wifi_ethtool_get_stats,
+	.get_ringparam = nrf_wifi_ethtool_get_ringparam,
+	.set_ringparam = nrf_wifi_ethtool_set_ringparam,
+	.get_coalesce = nrf_wifi_ethtool_get_coalesce,
+	.set_coalesce = nrf_wifi_ethtool_set_coalesce,
+};
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
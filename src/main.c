@@ -42,8 +42,6 @@ module_param(phy_calib, uint, 0000);
 MODULE_PARM_DESC(phy_calib,
 		 "Configure the bitmap of the PHY calibrations required");
 
-/* 3 bytes for addreess, 3 bytes for length */
-#define MAX_PKT_RAM_TX_ALIGN_OVERHEAD 6
 #define MAX_RX_QUEUES 3
 
 extern const uint8_t _binary_nrf70_bin_start[];
@@ -104,6 +102,57 @@ MODULE_PARM_DESC(rx3_buf_sz, "Rx3 pkt size");
 
 MODULE_PARM_DESC(rate_protection_type, "0 (NONE), 1 (RTS/CTS), 2 (CTS2SELF)");
 
+#ifdef CONFIG_NRF700X_DATA_TX
+unsigned int tx_budget = CONFIG_NRF700X_MAX_TX_TOKENS *
+			 CONFIG_NRF700X_MAX_TX_AGGREGATION;
+
+module_param(tx_budget, uint, 0644);
+MODULE_PARM_DESC(tx_budget, "Default max frames handed to the FMAC per TX work run, set per interface with ethtool -C tx-frames");
+
+bool tx_fast_path;
+
+module_param(tx_fast_path, bool, 0644);
+MODULE_PARM_DESC(tx_fast_path,
+		 "Start TX right away for frames sent on an idle interface");
+
+bool tx_credit_adaptive = true;
+unsigned int tx_credit_min = 1;
+
+module_param(tx_credit_adaptive, bool, 0644);
+MODULE_PARM_DESC(tx_credit_adaptive,
+		 "Adapt the in-flight TX frames allowed per token to the backlog, the FMAC coalescing depth stays at max_tx_aggregation");
+module_param(tx_credit_min, uint, 0644);
+MODULE_PARM_DESC(tx_credit_min,
+		 "Lowest adaptive in-flight TX frames per token");
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+#ifndef CONFIG_NRF700X_RADIO_TEST
+unsigned int pktram_policy = NRF_WIFI_PKTRAM_POLICY_STATIC;
+unsigned int pktram_rx_heavy_pct = 75;
+unsigned int pktram_tx_heavy_pct = 40;
+unsigned int pktram_hold = 30;
+
+module_param(pktram_policy, uint, 0444);
+module_param(pktram_rx_heavy_pct, uint, 0644);
+module_param(pktram_tx_heavy_pct, uint, 0644);
+module_param(pktram_hold, uint, 0644);
+
+MODULE_PARM_DESC(pktram_policy,
+		 "Advisory PKTRAM split, only applied by reloading with the rx*_num_bufs shown in debugfs: 0 static (off), 1 RX heavy, 2 TX heavy, 3 auto");
+MODULE_PARM_DESC(pktram_rx_heavy_pct,
+		 "PKTRAM % recommended for RX buffers when RX heavy");
+MODULE_PARM_DESC(pktram_tx_heavy_pct,
+		 "PKTRAM % recommended for RX buffers when TX heavy");
+MODULE_PARM_DESC(pktram_hold,
+		 "Busy seconds in one direction before auto recommends a split");
+
+unsigned int sta_info_ttl_ms = 5000;
+
+module_param(sta_info_ttl_ms, uint, 0644);
+MODULE_PARM_DESC(sta_info_ttl_ms,
+		 "Age up to which get_station is answered from cache (0: off)");
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
+
 struct nrf_wifi_drv_priv_lnx rpu_drv_priv;
 
 #ifndef CONFIG_NRF700X_RADIO_TEST
@@ -223,7 +272,10 @@ struct nrf_wifi_ctx_lnx *nrf_wifi_fmac_dev_add_lnx(void)
 	rpu_ctx_lnx->wiphy = wiphy;
 	dev = &wiphy->dev;
 
-	INIT_LIST_HEAD(&rpu_ctx_lnx->cookie_list);
+#ifndef CONFIG_NRF700X_RADIO_TEST
+	nrf_wifi_pktram_init(rpu_ctx_lnx);
+	nrf_wifi_cookies_init(&rpu_ctx_lnx->cookies);
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
 
 	rpu_ctx = nrf_wifi_fmac_dev_add(rpu_drv_priv.fmac_priv, rpu_ctx_lnx);
 
@@ -536,6 +588,8 @@ nrf_wifi_fmac_dev_init_lnx(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
 		pr_err("%s: MAC address change failed\n", __func__);
 		goto out;
 	}
+
+	nrf_wifi_pktram_start(rpu_ctx_lnx);
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
 out:
 #ifndef CONFIG_NRF700X_RADIO_TEST
@@ -567,6 +621,8 @@ void nrf_wifi_fmac_dev_deinit_lnx(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
 	unsigned char if_idx = MAX_NUM_VIFS;
 	unsigned char i = 0;
 
+	nrf_wifi_pktram_stop(rpu_ctx_lnx);
+
 	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
 	def_dev_ctx = wifi_dev_priv(fmac_dev_ctx);
 
@@ -625,16 +681,14 @@ void nrf_wifi_chnl_get_callbk_fn(void *os_vif_ctx,
 
 	vif_ctx_lnx = os_vif_ctx;
 
-	vif_ctx_lnx->chan_def =
-		kmalloc(sizeof(struct nrf_wifi_chan_definition), GFP_KERNEL);
-	if (!vif_ctx_lnx->chan_def) {
-		pr_err("%s: Unable to allocate memory for chan_def\n",
-		       __func__);
+	if (!nrf_wifi_vif_cmd_rsp_lock(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CMD_GET_CHANNEL))
 		return;
-	}
 
-	memcpy(vif_ctx_lnx->chan_def, &info->chan_def,
+	memcpy(&vif_ctx_lnx->chan_def, &info->chan_def,
 	       sizeof(struct nrf_wifi_chan_definition));
+
+	nrf_wifi_vif_cmd_rsp_unlock(vif_ctx_lnx);
 }
 
 void nrf_wifi_tx_pwr_get_callbk_fn(void *os_vif_ctx,
@@ -645,8 +699,13 @@ void nrf_wifi_tx_pwr_get_callbk_fn(void *os_vif_ctx,
 
 	vif_ctx_lnx = os_vif_ctx;
 
+	if (!nrf_wifi_vif_cmd_rsp_lock(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CMD_GET_TX_POWER))
+		return;
+
 	vif_ctx_lnx->tx_power = info->txpwr_level;
-	vif_ctx_lnx->event_tx_power = 1;
+
+	nrf_wifi_vif_cmd_rsp_unlock(vif_ctx_lnx);
 }
 
 void nrf_wifi_get_station_callbk_fn(void *os_vif_ctx,
@@ -657,16 +716,14 @@ void nrf_wifi_get_station_callbk_fn(void *os_vif_ctx,
 
 	vif_ctx_lnx = os_vif_ctx;
 
-	vif_ctx_lnx->station_info =
-		kmalloc(sizeof(struct nrf_wifi_sta_info), GFP_KERNEL);
-	if (!vif_ctx_lnx->station_info) {
-		pr_err("%s: Unable to allocate memory for station_info\n",
-		       __func__);
+	if (!nrf_wifi_vif_cmd_rsp_lock(vif_ctx_lnx,
+				       NRF_WIFI_VIF_CMD_GET_STATION))
 		return;
-	}
 
-	memcpy(vif_ctx_lnx->station_info, &info->sta_info,
+	memcpy(&vif_ctx_lnx->station_info, &info->sta_info,
 	       sizeof(struct nrf_wifi_sta_info));
+
+	nrf_wifi_vif_cmd_rsp_unlock(vif_ctx_lnx);
 }
 
 void nrf_wifi_disp_scan_res_callbk_fn(
@@ -683,23 +740,12 @@ void nrf_wifi_cookie_rsp_callbk_fn(
 {
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
-	struct cookie_info *cookie_info = NULL;
 
 	vif_ctx_lnx = os_vif_ctx;
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
-	cookie_info = kzalloc(sizeof(*cookie_info), GFP_KERNEL);
-
-	if (!cookie_info) {
-		pr_err("%s: Unable to allocate memory for cookie_info\n",
-		       __func__);
-		return;
-	}
-
-	cookie_info->host_cookie = cookie_rsp->host_cookie;
-	cookie_info->rpu_cookie = cookie_rsp->cookie;
-
-	list_add(&cookie_info->list, &rpu_ctx_lnx->cookie_list);
+	nrf_wifi_cookie_add(&rpu_ctx_lnx->cookies, cookie_rsp->host_cookie,
+			    cookie_rsp->cookie);
 }
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
 
@@ -723,6 +769,7 @@ static void nrf_wifi_process_rssi_from_rx(void *os_vif_ctx, signed short signal)
 	vif_ctx_lnx->rssi = MBM_TO_DBM(signal);
 	vif_ctx_lnx->rssi_record_timestamp_us =
 		nrf_wifi_osal_time_get_curr_us(fmac_dev_ctx->fpriv->opriv);
+	nrf_wifi_cqm_rssi(vif_ctx_lnx, vif_ctx_lnx->rssi);
 }
 #endif /* CONFIG_NRF700X_STA_MODE */
 
@@ -735,8 +782,12 @@ void nrf_wifi_set_if_callbk_fn(
 
 	vif_ctx_lnx = os_vif_ctx;
 
-	vif_ctx_lnx->event_set_if = 1;
+	if (!nrf_wifi_vif_cmd_rsp_lock(vif_ctx_lnx, NRF_WIFI_VIF_CMD_SET_IF))
+		return;
+
 	vif_ctx_lnx->status_set_if = set_if_event->return_value;
+
+	nrf_wifi_vif_cmd_rsp_unlock(vif_ctx_lnx);
 }
 
 void nrf_wifi_twt_config_callbk_fn(
@@ -814,6 +865,44 @@ void nrf_wifi_twt_sleep_callbk_fn(
 #endif /* CONFIG_NRF_WIFI_LOW_POWER */
 
 #ifndef CONFIG_NRF700X_RADIO_TEST
+/* The pools are set from the module parameters before the FMAC is up */
+void nrf_wifi_rx_pools_get(struct rx_buf_pool_params *pools)
+{
+	memcpy(pools, rpu_drv_priv.rx_pools, sizeof(rpu_drv_priv.rx_pools));
+}
+
+/* Called from NAPI; the pools are fixed for the life of the module */
+void nrf_wifi_rx_pools_sample(struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx)
+{
+	struct nrf_wifi_fmac_dev_ctx_def *def_dev_ctx = NULL;
+	struct nrf_wifi_rx_pool_stats *pool_stats = NULL;
+	unsigned int posted = 0;
+	unsigned int desc = 0;
+	unsigned int i = 0;
+	int pool = 0;
+
+	def_dev_ctx = wifi_dev_priv(fmac_dev_ctx);
+
+	if (!def_dev_ctx->rx_buf_info)
+		return;
+
+	/* The pools own consecutive descriptor ranges, in pool order */
+	for (pool = 0; pool < MAX_NUM_OF_RX_QUEUES; pool++) {
+		pool_stats = &rpu_drv_priv.rx_pool_stats[pool];
+		posted = 0;
+
+		for (i = 0; i < rpu_drv_priv.rx_pools[pool].num_bufs; i++)
+			if (def_dev_ctx->rx_buf_info[desc++].mapped)
+				posted++;
+
+		WRITE_ONCE(pool_stats->posted, posted);
+		if (posted < pool_stats->min_posted)
+			WRITE_ONCE(pool_stats->min_posted, posted);
+		if (!posted)
+			pool_stats->starved++;
+		pool_stats->samples++;
+	}
+}
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
 
 int nrf_wifi_dbgfs_init(void)
@@ -848,6 +937,7 @@ int __init nrf_wifi_init_lnx(void)
 	struct nrf_wifi_fmac_callbk_fns callbk_fns;
 	struct nrf_wifi_data_config_params data_config;
 	struct rx_buf_pool_params rx_buf_pools[MAX_NUM_OF_RX_QUEUES];
+	int i = 0;
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
 
 	ret = nrf_wifi_dbgfs_init();
@@ -884,6 +974,12 @@ int __init nrf_wifi_init_lnx(void)
 	rx_buf_pools[0].buf_sz = rx1_buf_sz;
 	rx_buf_pools[1].buf_sz = rx2_buf_sz;
 	rx_buf_pools[2].buf_sz = rx3_buf_sz;
+
+	memcpy(rpu_drv_priv.rx_pools, rx_buf_pools,
+	       sizeof(rpu_drv_priv.rx_pools));
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++)
+		rpu_drv_priv.rx_pool_stats[i].min_posted =
+			rx_buf_pools[i].num_bufs;
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
 
 	rpu_drv_priv.drv_init = false;
@@ -8,114 +8,726 @@
 #include <net/cfg80211.h>
 #include <linux/etherdevice.h>
 #include <linux/rtnetlink.h>
+#include <linux/crc32.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <linux/bpf_trace.h>
+#include <net/codel.h>
+#include <net/codel_impl.h>
+#include <net/fq.h>
+#include <net/fq_impl.h>
 
 #include "host_rpu_umac_if.h"
 #include "main.h"
 #include "fmac_main.h"
 #include "fmac_api.h"
 #include "fmac_util.h"
-#include "queue.h"
+#include "net_stack.h"
+#include "cfg80211_if.h"
+
+/* Frames waiting for the NAPI poll, beyond this the RX callback drops */
+#define NRF_WIFI_RX_NAPI_QLEN (4 * NAPI_POLL_WEIGHT)
 
 #ifdef CONFIG_NRF700X_DATA_TX
+extern unsigned int tx_budget;
+extern bool tx_fast_path;
+extern unsigned char wmm;
+extern unsigned char max_tx_aggregation;
+extern bool tx_credit_adaptive;
+extern unsigned int tx_credit_min;
 
-static void nrf_cfg80211_data_tx_routine(struct work_struct *w)
+/* How often the TX credit depth is re-evaluated */
+#define NRF_WIFI_TX_CREDIT_INTERVAL msecs_to_jiffies(100)
+
+#define NRF_WIFI_TXQ_WAKE_THRESH(vif_ctx_lnx)                                  \
+	(READ_ONCE((vif_ctx_lnx)->tx_qlen) / 2)
+
+/* Flows hashed into the fair queue, shared by all access categories */
+#define NRF_WIFI_TX_FQ_FLOWS 1024
+
+#define NRF_WIFI_TX_CB_MAGIC 0x7e57
+
+/* Stamped into skb->cb of every data frame handed to the FMAC, so that the
+ * TX-done path (the FMAC frees the frame through the OSAL nbuf_free op) can
+ * find its way back to the interface.
+ */
+struct nrf_wifi_netdev_tx_cb {
+	u32 vif_id;
+	u32 len;
+	u16 magic;
+	u16 ac;
+	codel_time_t enqueue_time;
+};
+
+#define NRF_WIFI_TX_CB(skb) ((struct nrf_wifi_netdev_tx_cb *)((skb)->cb))
+
+/* Open interfaces by TX id. The FMAC may free frames of an interface that is
+ * already down or gone, a fresh id is allocated on every open so that those
+ * completions are never accounted against the wrong BQL state.
+ */
+static DEFINE_XARRAY_ALLOC1(nrf_wifi_tx_vifs);
+static u32 nrf_wifi_tx_vif_next;
+
+/* 802.1D user priority to netdev TX queue, one queue per access category */
+static const u16 nrf_wifi_1d_to_ac[8] = {
+	NL80211_AC_BE, NL80211_AC_BK, NL80211_AC_BK, NL80211_AC_BE,
+	NL80211_AC_VI, NL80211_AC_VI, NL80211_AC_VO, NL80211_AC_VO
+};
+
+#ifdef CONFIG_NRF700X_TCP_IP_CHECKSUM_OFFLOAD
+/*
+ * The RPU computes the L4 checksum of TCP/UDP frames when checksum offload
+ * is enabled, it expects the checksum field to be zero. Anything else the
+ * stack asks us to checksum is resolved in software.
+ */
+static int nrf_wifi_netdev_tx_csum(struct sk_buff *skb)
+{
+	unsigned int csum_off = 0;
+	unsigned char l4_proto = 0;
+
+	if (skb->ip_summed != CHECKSUM_PARTIAL)
+		return 0;
+
+	switch (skb->protocol) {
+	case htons(ETH_P_IP):
+		l4_proto = ip_hdr(skb)->protocol;
+		break;
+	case htons(ETH_P_IPV6):
+		l4_proto = ipv6_hdr(skb)->nexthdr;
+		break;
+	default:
+		break;
+	}
+
+	if (skb_checksum_start_offset(skb) != skb_transport_offset(skb))
+		return skb_checksum_help(skb);
+
+	if (!(l4_proto == IPPROTO_TCP &&
+	      skb->csum_offset == offsetof(struct tcphdr, check)) &&
+	    !(l4_proto == IPPROTO_UDP &&
+	      skb->csum_offset == offsetof(struct udphdr, check)))
+		return skb_checksum_help(skb);
+
+	csum_off = skb_checksum_start_offset(skb) + skb->csum_offset;
+
+	if (skb_ensure_writable(skb, csum_off + sizeof(__sum16)))
+		return -ENOMEM;
+
+	*(__sum16 *)(skb->data + csum_off) = 0;
+
+	return 0;
+}
+#endif /* CONFIG_NRF700X_TCP_IP_CHECKSUM_OFFLOAD */
+
+/* Frames are BQL completed from TX done and when the fair queue drops them,
+ * both run under the fq lock so that BQL only ever sees one completer.
+ */
+static void
+nrf_wifi_netdev_tx_drop(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+			struct sk_buff *skb)
+{
+	struct nrf_wifi_netdev_tx_cb *tx_cb = NRF_WIFI_TX_CB(skb);
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+
+	lockdep_assert_held(&vif_ctx_lnx->tx_fq.lock);
+
+	netdev_tx_completed_queue(netdev_get_tx_queue(vif_ctx_lnx->netdev,
+						      tx_cb->ac),
+				  1, tx_cb->len);
+
+	stats = this_cpu_ptr(vif_ctx_lnx->stats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->tx_dropped++;
+	u64_stats_update_end(&stats->syncp);
+
+	tx_cb->magic = 0;
+	dev_kfree_skb_any(skb);
+}
+
+static void nrf_wifi_netdev_fq_free(struct fq *fq, struct fq_tin *tin,
+				    struct fq_flow *flow, struct sk_buff *skb)
+{
+	nrf_wifi_netdev_tx_drop(container_of(fq,
+					     struct nrf_wifi_fmac_vif_ctx_lnx,
+					     tx_fq),
+				skb);
+}
+
+static bool nrf_wifi_netdev_fq_flush(struct fq *fq, struct fq_tin *tin,
+				     struct fq_flow *flow, struct sk_buff *skb,
+				     void *data)
+{
+	/* Nothing queued for the old BSS is worth sending on the next one */
+	return true;
+}
+
+struct nrf_wifi_netdev_codel_ctx {
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx;
+	struct fq_flow *flow;
+};
+
+static u32 nrf_wifi_netdev_codel_len(const struct sk_buff *skb)
+{
+	return skb->len;
+}
+
+static codel_time_t nrf_wifi_netdev_codel_time(const struct sk_buff *skb)
+{
+	return NRF_WIFI_TX_CB(skb)->enqueue_time;
+}
+
+static void nrf_wifi_netdev_codel_drop(struct sk_buff *skb, void *ctx)
+{
+	struct nrf_wifi_netdev_codel_ctx *codel_ctx = ctx;
+
+	nrf_wifi_netdev_tx_drop(codel_ctx->vif_ctx_lnx, skb);
+}
+
+static struct sk_buff *nrf_wifi_netdev_codel_dequeue(struct codel_vars *cvars,
+						     void *ctx)
+{
+	struct nrf_wifi_netdev_codel_ctx *codel_ctx = ctx;
+
+	return fq_flow_dequeue(&codel_ctx->vif_ctx_lnx->tx_fq, codel_ctx->flow);
+}
+
+static struct sk_buff *nrf_wifi_netdev_fq_dequeue(struct fq *fq,
+						  struct fq_tin *tin,
+						  struct fq_flow *flow)
 {
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx =
-		container_of(w, struct nrf_wifi_fmac_vif_ctx_lnx, ws_data_tx);
-	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
+		container_of(fq, struct nrf_wifi_fmac_vif_ctx_lnx, tx_fq);
+	struct nrf_wifi_netdev_codel_ctx codel_ctx = {
+		.vif_ctx_lnx = vif_ctx_lnx,
+		.flow = flow,
+	};
+	struct codel_vars *cvars = NULL;
+
+	/* Flows colliding with another AC fall back to the tin default flow */
+	if (flow == &tin->default_flow)
+		cvars = &vif_ctx_lnx->tx_def_cvars[tin - vif_ctx_lnx->tx_tin];
+	else
+		cvars = &vif_ctx_lnx->tx_cvars[flow - fq->flows];
+
+	return codel_dequeue(&codel_ctx, &flow->backlog,
+			     &vif_ctx_lnx->tx_cparams, cvars,
+			     &vif_ctx_lnx->tx_cstats,
+			     nrf_wifi_netdev_codel_len,
+			     nrf_wifi_netdev_codel_time,
+			     nrf_wifi_netdev_codel_drop,
+			     nrf_wifi_netdev_codel_dequeue);
+}
+
+static int
+nrf_wifi_netdev_fq_init(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	int ret = -1;
+	int i = 0;
+
+	ret = fq_init(&vif_ctx_lnx->tx_fq, NRF_WIFI_TX_FQ_FLOWS);
+	if (ret)
+		return ret;
+
+	vif_ctx_lnx->tx_cvars = kcalloc(NRF_WIFI_TX_FQ_FLOWS,
+					sizeof(*vif_ctx_lnx->tx_cvars),
+					GFP_KERNEL);
+	if (!vif_ctx_lnx->tx_cvars) {
+		fq_reset(&vif_ctx_lnx->tx_fq, nrf_wifi_netdev_fq_free);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < NRF_WIFI_TX_FQ_FLOWS; i++)
+		codel_vars_init(&vif_ctx_lnx->tx_cvars[i]);
+
+	for (i = 0; i < NL80211_NUM_ACS; i++) {
+		fq_tin_init(&vif_ctx_lnx->tx_tin[i]);
+		codel_vars_init(&vif_ctx_lnx->tx_def_cvars[i]);
+	}
+
+	/* Same tuning as mac80211, the default 5 ms target is too tight for
+	 * the airtime of a single aggregate.
+	 */
+	codel_params_init(&vif_ctx_lnx->tx_cparams);
+	vif_ctx_lnx->tx_cparams.interval = MS2TIME(100);
+	vif_ctx_lnx->tx_cparams.target = MS2TIME(20);
+	vif_ctx_lnx->tx_cparams.mtu = ETH_FRAME_LEN;
+	vif_ctx_lnx->tx_cparams.ecn = true;
+	codel_stats_init(&vif_ctx_lnx->tx_cstats);
+
+	return 0;
+}
+
+static void
+nrf_wifi_netdev_fq_deinit(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	spin_lock_bh(&vif_ctx_lnx->tx_fq.lock);
+	fq_reset(&vif_ctx_lnx->tx_fq, nrf_wifi_netdev_fq_free);
+	spin_unlock_bh(&vif_ctx_lnx->tx_fq.lock);
+
+	kfree(vif_ctx_lnx->tx_cvars);
+	vif_ctx_lnx->tx_cvars = NULL;
+}
+
+static void
+nrf_wifi_netdev_tx_wake(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx, int ac)
+{
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	ktime_t stopped_at = vif_ctx_lnx->tx_stop_ts[ac];
+
+	netif_wake_subqueue(vif_ctx_lnx->netdev, ac);
+
+	local_bh_disable();
+	stats = this_cpu_ptr(vif_ctx_lnx->stats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->tx_queue_wakes++;
+	stats->tx_stopped_ns += ktime_to_ns(ktime_sub(ktime_get(), stopped_at));
+	u64_stats_update_end(&stats->syncp);
+	local_bh_enable();
+}
+
+/* Only the TX credits change, the FMAC keeps coalescing up to the
+ * max_tx_aggregation it was initialised with as its per token buffer
+ * layout depends on it. The depth limits how many frames are handed to
+ * it, so that no more than @depth of them wait for each token to come
+ * back.
+ */
+static void
+nrf_wifi_netdev_tx_credit_set(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+			   unsigned int depth)
+{
+	/* See nrf_wifi_netdev_tx_start() */
+	vif_ctx_lnx->tx_credit_depth = depth;
+	WRITE_ONCE(vif_ctx_lnx->tx_credits,
+		   (CONFIG_NRF700X_MAX_TX_TOKENS + 1) * depth);
+	WRITE_ONCE(vif_ctx_lnx->tx_credits_low,
+		   CONFIG_NRF700X_MAX_TX_TOKENS * depth);
+}
+
+/* Raise the in-flight limit quickly under bulk load, where an aggregate
+ * worth of frames keeps queueing up, and lower it step by step for sparse
+ * traffic so that frames do not wait in the FMAC. With DEBUG_MODE_SUPPORT
+ * the FMAC coalesce histogram refines the decision, otherwise only the
+ * fair queue backlog is used.
+ */
+static void
+nrf_wifi_netdev_tx_credit_update(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	unsigned int max_depth = max_t(unsigned int, max_tx_aggregation, 1);
+	unsigned int depth = vif_ctx_lnx->tx_credit_depth;
+	unsigned int backlog = vif_ctx_lnx->tx_credit_backlog;
+	unsigned int min_depth = 0;
+	bool raise = false;
+	bool lower = false;
+#ifdef DEBUG_MODE_SUPPORT
 	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
-	enum nrf_wifi_status status = NRF_WIFI_STATUS_FAIL;
-	void *netbuf = NULL;
+	struct nrf_wifi_fmac_dev_ctx_def *def_dev_ctx = NULL;
+	unsigned int *coalesce = NULL;
+	unsigned int batches = 0;
+	unsigned int frames = 0;
+	unsigned int full = 0;
+	unsigned int delta = 0;
+	int i = 0;
+#endif /* DEBUG_MODE_SUPPORT */
+
+	if (time_before(jiffies, vif_ctx_lnx->tx_credit_next))
+		return;
 
-	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
-	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
+	vif_ctx_lnx->tx_credit_next = jiffies + NRF_WIFI_TX_CREDIT_INTERVAL;
+	vif_ctx_lnx->tx_credit_backlog = 0;
 
-	netbuf = nrf_wifi_utils_q_dequeue(fmac_dev_ctx->fpriv->opriv,
-					  vif_ctx_lnx->data_txq);
-	if (netbuf == NULL) {
-		pr_err("%s: fail to get tx data from queue\n", __func__);
+	if (!READ_ONCE(tx_credit_adaptive)) {
+		if (depth != max_depth)
+			nrf_wifi_netdev_tx_credit_set(vif_ctx_lnx, max_depth);
 		return;
 	}
 
-	status = nrf_wifi_fmac_start_xmit(rpu_ctx_lnx->rpu_ctx,
-					  vif_ctx_lnx->if_idx, netbuf);
-	if (status != NRF_WIFI_STATUS_SUCCESS) {
-		pr_err("%s: nrf_wifi_fmac_start_xmit failed\n", __func__);
+	min_depth = clamp_t(unsigned int, READ_ONCE(tx_credit_min), 1,
+			    max_depth);
+
+	raise = backlog >= depth;
+	lower = backlog * 2 < depth;
+
+#ifdef DEBUG_MODE_SUPPORT
+	fmac_dev_ctx = vif_ctx_lnx->rpu_ctx->rpu_ctx;
+	def_dev_ctx = wifi_dev_priv(fmac_dev_ctx);
+	coalesce = def_dev_ctx->host_stats.tx_coalesce_frames;
+
+	/* Batches the FMAC built since the last update, by size. Deepen only
+	 * while it keeps filling the current depth and back off once its
+	 * batches stay well below it.
+	 */
+	for (i = 0; i < CONFIG_NRF700X_MAX_TX_AGGREGATION; i++) {
+		delta = READ_ONCE(coalesce[i]) -
+			vif_ctx_lnx->tx_coalesce_seen[i];
+		vif_ctx_lnx->tx_coalesce_seen[i] += delta;
+
+		batches += delta;
+		frames += delta * (i + 1);
+		if (i + 1 >= depth)
+			full += delta;
 	}
 
-	if (nrf_wifi_utils_q_len(fmac_dev_ctx->fpriv->opriv,
-				 vif_ctx_lnx->data_txq) > 0) {
-		schedule_work(&vif_ctx_lnx->ws_data_tx);
+	if (batches) {
+		raise = raise && (full * 2 >= batches);
+		lower = lower || (frames * 2 < batches * depth);
+	}
+#endif /* DEBUG_MODE_SUPPORT */
+
+	if (raise && depth < max_depth) {
+		depth = min(depth * 2, max_depth);
+		vif_ctx_lnx->tx_credit_raises++;
+	} else if (lower && depth > min_depth) {
+		depth--;
+		vif_ctx_lnx->tx_credit_lowers++;
 	}
+
+	depth = clamp(depth, min_depth, max_depth);
+
+	if (depth != vif_ctx_lnx->tx_credit_depth)
+		nrf_wifi_netdev_tx_credit_set(vif_ctx_lnx, depth);
 }
 
-static void nrf_cfg80211_queue_monitor_routine(struct work_struct *w)
+static void nrf_cfg80211_data_tx_routine(struct work_struct *w)
 {
-	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = container_of(
-		w, struct nrf_wifi_fmac_vif_ctx_lnx, ws_queue_monitor);
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx =
+		container_of(w, struct nrf_wifi_fmac_vif_ctx_lnx, ws_data_tx);
 	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
-	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
-	struct nrf_wifi_fmac_dev_ctx_def *def_dev_ctx = NULL;
-	struct rpu_host_stats *host_stats = NULL;
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	enum nrf_wifi_status status = NRF_WIFI_STATUS_FAIL;
+	struct fq *fq = &vif_ctx_lnx->tx_fq;
+	struct fq_tin *tin = NULL;
+	struct sk_buff *skb = NULL;
+	unsigned int backlog = 0;
+	unsigned int budget = 0;
+	unsigned int count = 0;
+	bool no_credits = false;
+	bool pending = false;
+	int ac = 0;
 
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
-	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
-	def_dev_ctx = wifi_dev_priv(fmac_dev_ctx);
-	host_stats = &def_dev_ctx->host_stats;
-
-	if (vif_ctx_lnx->num_tx_pkt - host_stats->total_tx_pkts <=
-	    CONFIG_NRF700X_MAX_TX_PENDING_QLEN / 2) {
-		if (netif_queue_stopped(vif_ctx_lnx->netdev)) {
-			netif_wake_queue(vif_ctx_lnx->netdev);
+	budget = max_t(unsigned int, READ_ONCE(vif_ctx_lnx->tx_budget), 1);
+
+	vif_ctx_lnx->tx_credit_backlog = max(vif_ctx_lnx->tx_credit_backlog,
+					  READ_ONCE(fq->backlog));
+	nrf_wifi_netdev_tx_credit_update(vif_ctx_lnx);
+
+	/* Frames handed over back to back while all TX tokens are busy are
+	 * queued by the FMAC and coalesced into the next free token. The
+	 * access categories are served in priority order (NL80211_AC_VO
+	 * first) and frames stay in the fair queue once the TX credits are
+	 * used up, so that voice and video never wait behind bulk traffic
+	 * and CoDel sees the standing queue.
+	 */
+	for (ac = 0; ac < NL80211_NUM_ACS; ac++) {
+		tin = &vif_ctx_lnx->tx_tin[ac];
+
+		while (count < budget) {
+			if (atomic_read(&vif_ctx_lnx->tx_inflight) >=
+			    READ_ONCE(vif_ctx_lnx->tx_credits)) {
+				no_credits = true;
+				break;
+			}
+
+			spin_lock_bh(&fq->lock);
+			skb = fq_tin_dequeue(fq, tin,
+					     nrf_wifi_netdev_fq_dequeue);
+			spin_unlock_bh(&fq->lock);
+
+			if (!skb)
+				break;
+
+			atomic_inc(&vif_ctx_lnx->tx_inflight);
+
+			status = nrf_wifi_fmac_start_xmit(rpu_ctx_lnx->rpu_ctx,
+							  vif_ctx_lnx->if_idx,
+							  skb);
+			if (status != NRF_WIFI_STATUS_SUCCESS) {
+				pr_err("%s: nrf_wifi_fmac_start_xmit failed\n",
+				       __func__);
+				local_bh_disable();
+				stats = this_cpu_ptr(vif_ctx_lnx->stats);
+				u64_stats_update_begin(&stats->syncp);
+				stats->tx_errors++;
+				u64_stats_update_end(&stats->syncp);
+				local_bh_enable();
+			}
+			count++;
 		}
-	} else {
-		schedule_work(&vif_ctx_lnx->ws_queue_monitor);
+
+		backlog = READ_ONCE(tin->backlog_packets);
+
+		if (backlog <= NRF_WIFI_TXQ_WAKE_THRESH(vif_ctx_lnx) &&
+		    __netif_subqueue_stopped(vif_ctx_lnx->netdev, ac))
+			nrf_wifi_netdev_tx_wake(vif_ctx_lnx, ac);
+
+		if (backlog)
+			pending = true;
+	}
+
+	if (no_credits) {
+		/* TX done restarts us once enough credits are back, re-check
+		 * in case the last completion raced with setting the flag.
+		 */
+		local_bh_disable();
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_credit_stalls++;
+		u64_stats_update_end(&stats->syncp);
+		local_bh_enable();
+
+		set_bit(NRF_WIFI_TX_NO_CREDITS, &vif_ctx_lnx->tx_flags);
+		smp_mb__after_atomic();
+
+		if (atomic_read(&vif_ctx_lnx->tx_inflight) >
+		    READ_ONCE(vif_ctx_lnx->tx_credits_low))
+			return;
+
+		if (!test_and_clear_bit(NRF_WIFI_TX_NO_CREDITS,
+					&vif_ctx_lnx->tx_flags))
+			return;
 	}
+
+	if (pending)
+		queue_work(vif_ctx_lnx->tx_wq, &vif_ctx_lnx->ws_data_tx);
+}
+
+bool nrf_wifi_netdev_tx_done(struct sk_buff *skb)
+{
+	struct nrf_wifi_netdev_tx_cb *tx_cb = NRF_WIFI_TX_CB(skb);
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	struct netdev_queue *txq = NULL;
+	int inflight = 0;
+
+	if (tx_cb->magic != NRF_WIFI_TX_CB_MAGIC)
+		return false;
+
+	tx_cb->magic = 0;
+
+	/* Called from the FMAC event work, keep the softirqs raised by the
+	 * queue wakeup from being left pending.
+	 */
+	local_bh_disable();
+	rcu_read_lock();
+
+	vif_ctx_lnx = xa_load(&nrf_wifi_tx_vifs, tx_cb->vif_id);
+	if (vif_ctx_lnx) {
+		txq = netdev_get_tx_queue(vif_ctx_lnx->netdev, tx_cb->ac);
+		spin_lock(&vif_ctx_lnx->tx_fq.lock);
+		netdev_tx_completed_queue(txq, 1, tx_cb->len);
+		spin_unlock(&vif_ctx_lnx->tx_fq.lock);
+
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_packets++;
+		stats->tx_bytes += tx_cb->len;
+		u64_stats_update_end(&stats->syncp);
+
+		inflight = atomic_dec_return(&vif_ctx_lnx->tx_inflight);
+
+		if (inflight <= READ_ONCE(vif_ctx_lnx->tx_credits_low) &&
+		    test_and_clear_bit(NRF_WIFI_TX_NO_CREDITS,
+				       &vif_ctx_lnx->tx_flags))
+			queue_work(vif_ctx_lnx->tx_wq,
+				   &vif_ctx_lnx->ws_data_tx);
+	}
+
+	rcu_read_unlock();
+	local_bh_enable();
+
+	dev_consume_skb_any(skb);
+
+	return true;
+}
+
+static int
+nrf_wifi_netdev_tx_start(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	int ret = -1;
+
+	/* Enough to fill every TX token plus one aggregate waiting for the
+	 * next free token, which keeps the air busy. Anything beyond that
+	 * would only build an FMAC FIFO that CoDel cannot see, so the rest
+	 * stays in the fair queue. The TX work resumes once an aggregate
+	 * worth of credits is back.
+	 */
+	vif_ctx_lnx->tx_credits = (CONFIG_NRF700X_MAX_TX_TOKENS + 1) *
+				  vif_ctx_lnx->tx_credit_depth;
+	vif_ctx_lnx->tx_credits_low =
+		vif_ctx_lnx->tx_credits - vif_ctx_lnx->tx_credit_depth;
+	atomic_set(&vif_ctx_lnx->tx_inflight, 0);
+	clear_bit(NRF_WIFI_TX_NO_CREDITS, &vif_ctx_lnx->tx_flags);
+
+	ret = xa_alloc_cyclic(&nrf_wifi_tx_vifs, &vif_ctx_lnx->tx_id,
+			      vif_ctx_lnx, xa_limit_32b, &nrf_wifi_tx_vif_next,
+			      GFP_KERNEL);
+	if (ret < 0) {
+		pr_err("%s: Unable to allocate a TX id, ret=%d\n", __func__,
+		       ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+static void
+nrf_wifi_netdev_tx_stop(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	struct net_device *netdev = vif_ctx_lnx->netdev;
+	int i = 0;
+
+	flush_work(&vif_ctx_lnx->ws_data_tx);
+
+	xa_erase(&nrf_wifi_tx_vifs, vif_ctx_lnx->tx_id);
+	synchronize_rcu();
+
+	spin_lock_bh(&vif_ctx_lnx->tx_fq.lock);
+	for (i = 0; i < NL80211_NUM_ACS; i++)
+		fq_tin_reset(&vif_ctx_lnx->tx_fq, &vif_ctx_lnx->tx_tin[i],
+			     nrf_wifi_netdev_fq_free);
+	spin_unlock_bh(&vif_ctx_lnx->tx_fq.lock);
+
+	for (i = 0; i < NL80211_NUM_ACS; i++)
+		netdev_tx_reset_queue(netdev_get_tx_queue(netdev, i));
+}
+
+static void
+nrf_wifi_netdev_tx_flush(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	int i = 0;
+
+	spin_lock_bh(&vif_ctx_lnx->tx_fq.lock);
+	for (i = 0; i < NL80211_NUM_ACS; i++)
+		fq_tin_filter(&vif_ctx_lnx->tx_fq, &vif_ctx_lnx->tx_tin[i],
+			      nrf_wifi_netdev_fq_flush, NULL,
+			      nrf_wifi_netdev_fq_free);
+	spin_unlock_bh(&vif_ctx_lnx->tx_fq.lock);
+
+	/* Let the TX work wake up the queues stopped on the full backlog */
+	queue_work(vif_ctx_lnx->tx_wq, &vif_ctx_lnx->ws_data_tx);
+}
+
+static bool
+nrf_wifi_netdev_tx_idle(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	if (atomic_read(&vif_ctx_lnx->tx_inflight))
+		return false;
+
+	return !READ_ONCE(vif_ctx_lnx->tx_fq.backlog);
+}
+
+static u16 nrf_wifi_netdev_select_queue(struct net_device *netdev,
+					struct sk_buff *skb,
+					struct net_device *sb_dev)
+{
+	if (!wmm)
+		return NL80211_AC_BE;
+
+	/* Takes skb->priority if set by the application, DSCP otherwise */
+	skb->priority = cfg80211_classify8021d(skb, NULL);
+
+	return nrf_wifi_1d_to_ac[skb->priority & 7];
 }
 
 netdev_tx_t nrf_wifi_netdev_start_xmit(struct sk_buff *skb,
 				       struct net_device *netdev)
 {
-	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
-	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
-	struct nrf_wifi_fmac_dev_ctx_def *def_dev_ctx = NULL;
-	struct rpu_host_stats *host_stats = NULL;
-	int status = -1;
+	struct nrf_wifi_netdev_tx_cb *tx_cb = NULL;
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	struct fq *fq = NULL;
+	struct fq_tin *tin = NULL;
 	int ret = NETDEV_TX_OK;
+	unsigned int backlog = 0;
+	unsigned int len = 0;
+	bool kick = false;
+	bool fast = false;
+	u16 ac = 0;
 
 	vif_ctx_lnx = netdev_priv(netdev);
-	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
-
-	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
-
-	def_dev_ctx = wifi_dev_priv(fmac_dev_ctx);
-	host_stats = &def_dev_ctx->host_stats;
 
 	if (skb->dev != netdev) {
 		pr_err("%s: wrong net dev\n", __func__);
 		goto out;
 	}
 
-	if ((vif_ctx_lnx->num_tx_pkt - host_stats->total_tx_pkts) >=
-	    CONFIG_NRF700X_MAX_TX_PENDING_QLEN) {
-		if (!netif_queue_stopped(netdev)) {
-			netif_stop_queue(netdev);
-		}
-		schedule_work(&vif_ctx_lnx->ws_queue_monitor);
+#ifdef CONFIG_NRF700X_TCP_IP_CHECKSUM_OFFLOAD
+	if (nrf_wifi_netdev_tx_csum(skb)) {
+		pr_err("%s: checksum preparation failed\n", __func__);
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_dropped++;
+		u64_stats_update_end(&stats->syncp);
+		dev_kfree_skb_any(skb);
+		goto out;
+	}
+#endif /* CONFIG_NRF700X_TCP_IP_CHECKSUM_OFFLOAD */
+
+	ac = skb_get_queue_mapping(skb);
+	if (ac >= NL80211_NUM_ACS)
+		ac = NL80211_AC_BE;
+
+	len = skb->len;
+
+	tx_cb = NRF_WIFI_TX_CB(skb);
+	tx_cb->vif_id = vif_ctx_lnx->tx_id;
+	tx_cb->len = len;
+	tx_cb->ac = ac;
+	tx_cb->magic = NRF_WIFI_TX_CB_MAGIC;
+
+	fast = READ_ONCE(tx_fast_path) && nrf_wifi_netdev_tx_idle(vif_ctx_lnx);
+
+	/* Account the frame before the TX worker can possibly complete it */
+	kick = __netdev_tx_sent_queue(netdev_get_tx_queue(netdev, ac), len,
+				      netdev_xmit_more());
+
+	fq = &vif_ctx_lnx->tx_fq;
+	tin = &vif_ctx_lnx->tx_tin[ac];
+	tx_cb->enqueue_time = codel_get_time();
+
+	/* Over the fq limits the fattest flow of any AC is dropped */
+	spin_lock(&fq->lock);
+	fq_tin_enqueue(fq, tin, fq_flow_idx(fq, skb), skb,
+		       nrf_wifi_netdev_fq_free);
+	backlog = tin->backlog_packets;
+	spin_unlock(&fq->lock);
+
+	if (backlog >= READ_ONCE(vif_ctx_lnx->tx_qlen) &&
+	    !__netif_subqueue_stopped(netdev, ac)) {
+		netif_stop_subqueue(netdev, ac);
+		vif_ctx_lnx->tx_stop_ts[ac] = ktime_get();
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_queue_stops++;
+		u64_stats_update_end(&stats->syncp);
 	}
 
-	status = nrf_wifi_utils_q_enqueue(fmac_dev_ctx->fpriv->opriv,
-					  vif_ctx_lnx->data_txq, skb);
-
-	if (status != NRF_WIFI_STATUS_SUCCESS) {
-		pr_err("%s: nrf_wifi_utils_q_enqueue failed\n", __func__);
-		ret = NETDEV_TX_BUSY;
-		return ret;
+	if (fast) {
+		/* Nothing to batch with, start the TX work right away on
+		 * this CPU.
+		 */
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->tx_fast_pkts++;
+		u64_stats_update_end(&stats->syncp);
+		queue_work_on(raw_smp_processor_id(), vif_ctx_lnx->tx_wq,
+			      &vif_ctx_lnx->ws_data_tx);
+		goto out;
 	}
 
-	vif_ctx_lnx->num_tx_pkt++;
-	schedule_work(&vif_ctx_lnx->ws_data_tx);
+	stats = this_cpu_ptr(vif_ctx_lnx->stats);
+	u64_stats_update_begin(&stats->syncp);
+	stats->tx_deferred_pkts++;
+	u64_stats_update_end(&stats->syncp);
+
+	/* Let the stack finish the burst before waking up the TX worker */
+	if (kick || __netif_subqueue_stopped(netdev, ac) ||
+	    backlog >= READ_ONCE(vif_ctx_lnx->tx_budget))
+		queue_work(vif_ctx_lnx->tx_wq, &vif_ctx_lnx->ws_data_tx);
 
 out:
 	return ret;
@@ -139,6 +751,15 @@ int nrf_wifi_netdev_open(struct net_device *netdev)
 		goto out;
 	}
 
+#ifdef CONFIG_NRF700X_DATA_TX
+	status = nrf_wifi_netdev_tx_start(vif_ctx_lnx);
+
+	if (status) {
+		status = NRF_WIFI_STATUS_FAIL;
+		goto out;
+	}
+#endif /* CONFIG_NRF700X_DATA_TX */
+
 	vif_info->state = 1;
 
 	vif_info->if_index = vif_ctx_lnx->if_idx;
@@ -148,9 +769,14 @@ int nrf_wifi_netdev_open(struct net_device *netdev)
 
 	if (status == NRF_WIFI_STATUS_FAIL) {
 		pr_err("%s: nrf_wifi_fmac_chg_vif_state failed\n", __func__);
+#ifdef CONFIG_NRF700X_DATA_TX
+		nrf_wifi_netdev_tx_stop(vif_ctx_lnx);
+#endif /* CONFIG_NRF700X_DATA_TX */
 		goto out;
 	}
 
+	napi_enable(&vif_ctx_lnx->napi);
+
 out:
 	if (vif_info)
 		kfree(vif_info);
@@ -168,6 +794,13 @@ int nrf_wifi_netdev_close(struct net_device *netdev)
 	vif_ctx_lnx = netdev_priv(netdev);
 	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 
+#ifdef CONFIG_NRF700X_DATA_TX
+	nrf_wifi_netdev_tx_stop(vif_ctx_lnx);
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+	napi_disable(&vif_ctx_lnx->napi);
+	skb_queue_purge(&vif_ctx_lnx->rx_napi_q);
+
 	vif_info = kzalloc(sizeof(*vif_info), GFP_KERNEL);
 
 	if (!vif_info) {
@@ -186,10 +819,16 @@ int nrf_wifi_netdev_close(struct net_device *netdev)
 		pr_err("%s: nrf_wifi_fmac_chg_vif_state failed\n", __func__);
 		goto out;
 	}
-	flush_work(&vif_ctx_lnx->ws_data_tx);
-	flush_work(&vif_ctx_lnx->ws_queue_monitor);
 
 	netif_carrier_off(netdev);
+
+	/* Do not rely on the UMAC keeping the multicast addresses of an
+	 * interface that went down, have them all sent again by the rx_mode
+	 * update on open.
+	 */
+	netif_addr_lock_bh(netdev);
+	__dev_mc_unsync(netdev, NULL);
+	netif_addr_unlock_bh(netdev);
 out:
 	if (vif_info)
 		kfree(vif_info);
@@ -197,61 +836,542 @@ out:
 	return status;
 }
 
-void nrf_wifi_netdev_set_multicast_list(struct net_device *netdev)
+struct nrf_wifi_netdev_mc_cmd {
+	struct list_head list;
+	unsigned char addr[ETH_ALEN];
+	bool add;
+};
+
+static u32 nrf_wifi_netdev_mc_hash(const unsigned char *addr)
 {
-	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
-	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	return ether_crc(ETH_ALEN, addr) >>
+	       (32 - ilog2(NRF_WIFI_MC_FILTER_BITS));
+}
+
+static int nrf_wifi_netdev_mc_queue(struct net_device *netdev,
+				    const unsigned char *addr, bool add)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	struct nrf_wifi_netdev_mc_cmd *cmd = NULL;
+
+	cmd = kzalloc(sizeof(*cmd), GFP_ATOMIC);
+	if (!cmd)
+		return -ENOMEM;
+
+	ether_addr_copy(cmd->addr, addr);
+	cmd->add = add;
+
+	spin_lock_bh(&vif_ctx_lnx->mc_lock);
+	list_add_tail(&cmd->list, &vif_ctx_lnx->mc_cmds);
+	spin_unlock_bh(&vif_ctx_lnx->mc_lock);
+
+	return 0;
+}
+
+static int nrf_wifi_netdev_mc_sync(struct net_device *netdev,
+				   const unsigned char *addr)
+{
+	return nrf_wifi_netdev_mc_queue(netdev, addr, true);
+}
+
+static int nrf_wifi_netdev_mc_unsync(struct net_device *netdev,
+				     const unsigned char *addr)
+{
+	return nrf_wifi_netdev_mc_queue(netdev, addr, false);
+}
+
+/* The UMAC commands sleep, ndo_set_rx_mode only queues them */
+static void nrf_wifi_netdev_rx_mode_work(struct work_struct *w)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx =
+		container_of(w, struct nrf_wifi_fmac_vif_ctx_lnx, ws_rx_mode);
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
 	struct nrf_wifi_umac_mcast_cfg *mcast_info = NULL;
-	int status = -1;
-	struct netdev_hw_addr *ha = NULL;
-	int indx = 0, count = 0;
+	struct nrf_wifi_netdev_mc_cmd *cmd = NULL;
+	struct nrf_wifi_netdev_mc_cmd *tmp = NULL;
+	enum nrf_wifi_status status = NRF_WIFI_STATUS_FAIL;
+	LIST_HEAD(cmds);
 
-	vif_ctx_lnx = netdev_priv(netdev);
-	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
+	spin_lock_bh(&vif_ctx_lnx->mc_lock);
+	list_splice_init(&vif_ctx_lnx->mc_cmds, &cmds);
+	spin_unlock_bh(&vif_ctx_lnx->mc_lock);
 
-	count = netdev_mc_count(netdev);
-	mcast_info =
-		kzalloc((sizeof(*mcast_info) + (count * NRF_WIFI_ETH_ADDR_LEN)),
-			GFP_KERNEL);
+	mcast_info = kzalloc(sizeof(*mcast_info), GFP_KERNEL);
 
-	if (!mcast_info) {
+	if (!mcast_info)
 		pr_err("%s: Unable to allocate memory\n", __func__);
-		goto out;
-	}
 
-	netdev_for_each_mc_addr(ha, netdev) {
-		memcpy(((char *)(mcast_info->mac_addr) +
-			(indx * NRF_WIFI_ETH_ADDR_LEN)),
-		       ha->addr, NRF_WIFI_ETH_ADDR_LEN);
-		indx++;
+	list_for_each_entry_safe(cmd, tmp, &cmds, list) {
+		list_del(&cmd->list);
+
+		if (mcast_info) {
+			mcast_info->type = cmd->add ? MCAST_ADDR_ADD :
+						      MCAST_ADDR_DEL;
+			memcpy(mcast_info->mac_addr, cmd->addr, ETH_ALEN);
+
+			status = nrf_wifi_fmac_set_mcast_addr(
+				rpu_ctx_lnx->rpu_ctx, vif_ctx_lnx->if_idx,
+				mcast_info);
+
+			if (status == NRF_WIFI_STATUS_FAIL)
+				pr_err("%s: set_mcast_addr failed\n",
+				       __func__);
+			else if (cmd->add)
+				vif_ctx_lnx->mc_add_cmds++;
+			else
+				vif_ctx_lnx->mc_del_cmds++;
+		}
+
+		kfree(cmd);
 	}
-	status = nrf_wifi_fmac_set_mcast_addr(rpu_ctx_lnx->rpu_ctx,
-					      vif_ctx_lnx->if_idx, mcast_info);
 
-	if (status == NRF_WIFI_STATUS_FAIL) {
-		pr_err("%s: nrf_wifi_fmac_chg_vif_state failed\n", __func__);
-		goto out;
+	kfree(mcast_info);
+}
+
+/*
+ * Only addresses added or removed since the last call are sent to the UMAC,
+ * the core keeps track of what is synced. The UMAC passes all multicast
+ * while no address is programmed, which is what IFF_ALLMULTI/IFF_PROMISC
+ * need. Multicast the UMAC lets through anyway is filtered on a hash of the
+ * subscribed addresses before it reaches NAPI.
+ */
+static void nrf_wifi_netdev_set_rx_mode(struct net_device *netdev)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	DECLARE_BITMAP(filter, NRF_WIFI_MC_FILTER_BITS);
+	struct netdev_hw_addr *ha = NULL;
+	bool all = false;
+	int i = 0;
+
+	bitmap_zero(filter, NRF_WIFI_MC_FILTER_BITS);
+
+	all = netdev->flags & (IFF_ALLMULTI | IFF_PROMISC);
+
+	if (all) {
+		__dev_mc_unsync(netdev, nrf_wifi_netdev_mc_unsync);
+	} else {
+		__dev_mc_sync(netdev, nrf_wifi_netdev_mc_sync,
+			      nrf_wifi_netdev_mc_unsync);
+
+		netdev_for_each_mc_addr(ha, netdev)
+			__set_bit(nrf_wifi_netdev_mc_hash(ha->addr), filter);
 	}
 
-out:
-	if (mcast_info)
-		kfree(mcast_info);
+	for (i = 0; i < BITS_TO_LONGS(NRF_WIFI_MC_FILTER_BITS); i++)
+		WRITE_ONCE(vif_ctx_lnx->mc_filter[i], filter[i]);
+	WRITE_ONCE(vif_ctx_lnx->mc_all, all);
+
+	schedule_work(&vif_ctx_lnx->ws_rx_mode);
+}
+
+static bool
+nrf_wifi_netdev_mc_filtered(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+			    const unsigned char *addr)
+{
+	u32 hash = 0;
+
+	if (!is_multicast_ether_addr(addr) || is_broadcast_ether_addr(addr) ||
+	    READ_ONCE(vif_ctx_lnx->mc_all))
+		return false;
+
+	hash = nrf_wifi_netdev_mc_hash(addr);
+
+	return !(READ_ONCE(vif_ctx_lnx->mc_filter[BIT_WORD(hash)]) &
+		 BIT_MASK(hash));
 }
 
 void nrf_wifi_netdev_frame_rx_callbk_fn(void *os_vif_ctx, void *frm)
 {
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
 	struct sk_buff *skb = frm;
 	struct net_device *netdev = NULL;
 
 	vif_ctx_lnx = os_vif_ctx;
 	netdev = vif_ctx_lnx->netdev;
 
+	if (!netif_running(netdev) ||
+	    skb_queue_len(&vif_ctx_lnx->rx_napi_q) >= NRF_WIFI_RX_NAPI_QLEN) {
+		local_bh_disable();
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->rx_dropped++;
+		u64_stats_update_end(&stats->syncp);
+		local_bh_enable();
+		dev_kfree_skb_any(skb);
+		return;
+	}
+
+	if (nrf_wifi_netdev_mc_filtered(vif_ctx_lnx, skb->data)) {
+		local_bh_disable();
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->rx_mc_filtered++;
+		u64_stats_update_end(&stats->syncp);
+		local_bh_enable();
+		dev_kfree_skb_any(skb);
+		return;
+	}
+
+	skb_queue_tail(&vif_ctx_lnx->rx_napi_q, skb);
+
+	/* Called from the FMAC event work, disable BHs so that the NAPI
+	 * softirq runs right when they are enabled again.
+	 */
+	local_bh_disable();
+	napi_schedule(&vif_ctx_lnx->napi);
+	local_bh_enable();
+}
+
+#ifdef CONFIG_NRF700X_DATA_TX
+/* Queues an Ethernet frame coming from XDP to our own TX path, the same way
+ * the stack would but without going through the qdisc.
+ */
+static bool nrf_wifi_netdev_xdp_tx_skb(struct net_device *netdev,
+				       struct sk_buff *skb)
+{
+	struct netdev_queue *txq = NULL;
+	bool sent = false;
+
 	skb->dev = netdev;
-	skb->protocol = eth_type_trans(skb, skb->dev);
-	skb->ip_summed = CHECKSUM_UNNECESSARY; /* don't check it */
+	skb_reset_mac_header(skb);
+	skb_set_network_header(skb, ETH_HLEN);
+	skb->protocol = eth_hdr(skb)->h_proto;
+	skb_set_queue_mapping(skb,
+			      nrf_wifi_netdev_select_queue(netdev, skb, NULL));
+
+	txq = skb_get_tx_queue(netdev, skb);
+
+	__netif_tx_lock(txq, smp_processor_id());
+	if (!netif_xmit_frozen_or_drv_stopped(txq)) {
+		nrf_wifi_netdev_start_xmit(skb, netdev);
+		sent = true;
+	}
+	__netif_tx_unlock(txq);
+
+	return sent;
+}
+
+static int nrf_wifi_netdev_xdp_xmit(struct net_device *netdev, int n,
+				    struct xdp_frame **frames, u32 flags)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	struct sk_buff *skb = NULL;
+	int nxmit = 0;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (!netif_running(netdev) || !netif_carrier_ok(netdev))
+		return -ENETDOWN;
+
+	/* The FMAC only takes skbs, frames the core gets back are freed by
+	 * it, the ones turned into an skb are ours from then on.
+	 */
+	for (nxmit = 0; nxmit < n; nxmit++) {
+		skb = xdp_build_skb_from_frame(frames[nxmit], netdev);
+		if (!skb)
+			break;
+
+		__skb_push(skb, ETH_HLEN);
+
+		if (!nrf_wifi_netdev_xdp_tx_skb(netdev, skb)) {
+			stats = this_cpu_ptr(vif_ctx_lnx->stats);
+			u64_stats_update_begin(&stats->syncp);
+			stats->tx_dropped++;
+			u64_stats_update_end(&stats->syncp);
+			kfree_skb(skb);
+		}
+	}
 
-	netif_rx(skb);
+	return nxmit;
+}
+#endif /* CONFIG_NRF700X_DATA_TX */
+
+static int nrf_wifi_netdev_bpf(struct net_device *netdev,
+			       struct netdev_bpf *bpf)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	struct bpf_prog *old_prog = NULL;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		old_prog = rcu_replace_pointer(vif_ctx_lnx->xdp_prog, bpf->prog,
+					       lockdep_rtnl_is_held());
+		if (old_prog)
+			bpf_prog_put(old_prog);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Syncs the skb with what the XDP program did to the frame */
+static void nrf_wifi_netdev_xdp_adjust_skb(struct sk_buff *skb,
+					   struct xdp_buff *xdp)
+{
+	unsigned int metalen = 0;
+	int off = 0;
+
+	off = xdp->data - (void *)skb->data;
+	if (off > 0)
+		__skb_pull(skb, off);
+	else if (off < 0)
+		__skb_push(skb, -off);
+
+	skb->len = xdp->data_end - xdp->data;
+	skb_set_tail_pointer(skb, skb->len);
+
+	metalen = xdp->data - xdp->data_meta;
+	if (metalen)
+		skb_metadata_set(skb, metalen);
+}
+
+/*
+ * Runs the XDP program on an RX frame, which still starts with its Ethernet
+ * header. RX buffers are page fragments with XDP_PACKET_HEADROOM (see
+ * shim_nbuf_alloc()), the program runs on them in place and the skb is only
+ * given to the stack on XDP_PASS. Frames in any other buffer (e.g. a
+ * fallback allocation) go through generic XDP. Returns XDP_PASS when the
+ * frame is still ours, anything else means it has been consumed.
+ *
+ * do_xdp_generic() carries out XDP_TX and XDP_REDIRECT itself and returns
+ * XDP_DROP for them, so the program's verdict is only known for the frames
+ * run in place.
+ */
+static u32 nrf_wifi_netdev_xdp_rx(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+				  struct bpf_prog *prog, struct sk_buff *skb,
+				  bool *redirected)
+{
+	struct net_device *netdev = vif_ctx_lnx->netdev;
+	struct xdp_buff xdp;
+	u32 act = XDP_PASS;
+
+	if (!skb->head_frag || skb_cloned(skb) || skb_is_nonlinear(skb) ||
+	    skb_headroom(skb) < XDP_PACKET_HEADROOM) {
+		skb->protocol = eth_type_trans(skb, netdev);
+		act = do_xdp_generic(prog, skb);
+		if (act == XDP_PASS)
+			__skb_push(skb, skb->data - skb_mac_header(skb));
+		return act;
+	}
+
+	xdp_init_buff(&xdp,
+		      skb_end_offset(skb) +
+			      SKB_DATA_ALIGN(sizeof(struct skb_shared_info)),
+		      &vif_ctx_lnx->xdp_rxq);
+	xdp_prepare_buff(&xdp, skb->head, skb_headroom(skb), skb_headlen(skb),
+			 true);
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+
+	switch (act) {
+	case XDP_PASS:
+		nrf_wifi_netdev_xdp_adjust_skb(skb, &xdp);
+		break;
+	case XDP_TX:
+#ifdef CONFIG_NRF700X_DATA_TX
+		nrf_wifi_netdev_xdp_adjust_skb(skb, &xdp);
+		if (nrf_wifi_netdev_xdp_tx_skb(netdev, skb))
+			break;
+#endif /* CONFIG_NRF700X_DATA_TX */
+		trace_xdp_exception(netdev, prog, act);
+		kfree_skb(skb);
+		break;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(netdev, &xdp, prog)) {
+			trace_xdp_exception(netdev, prog, act);
+			kfree_skb(skb);
+			break;
+		}
+		/* The frame now belongs to the redirect target */
+		kfree_skb_partial(skb, true);
+		*redirected = true;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(netdev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		kfree_skb(skb);
+		break;
+	}
+
+	return act;
+}
+
+static int nrf_wifi_netdev_poll(struct napi_struct *napi, int budget)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx =
+		container_of(napi, struct nrf_wifi_fmac_vif_ctx_lnx, napi);
+	struct net_device *netdev = vif_ctx_lnx->netdev;
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	struct bpf_prog *prog = NULL;
+	struct sk_buff *skb = NULL;
+	bool redirected = false;
+	u64 xdp_drop = 0;
+	u64 xdp_tx = 0;
+	u64 xdp_redirect = 0;
+	u64 rx_multicast = 0;
+	u64 rx_bytes = 0;
+	int work_done = 0;
+	u32 act = XDP_PASS;
+
+	rcu_read_lock();
+	prog = rcu_dereference(vif_ctx_lnx->xdp_prog);
+
+	while (work_done < budget) {
+		skb = skb_dequeue(&vif_ctx_lnx->rx_napi_q);
+		if (!skb)
+			break;
+
+		rx_bytes += skb->len;
+		work_done++;
+
+		if (is_multicast_ether_addr(skb->data) &&
+		    !is_broadcast_ether_addr(skb->data))
+			rx_multicast++;
+
+		skb->dev = netdev;
+
+		if (prog) {
+			act = nrf_wifi_netdev_xdp_rx(vif_ctx_lnx, prog, skb,
+						     &redirected);
+			if (act == XDP_TX)
+				xdp_tx++;
+			else if (act == XDP_REDIRECT)
+				xdp_redirect++;
+			else if (act != XDP_PASS)
+				xdp_drop++;
+
+			if (act != XDP_PASS)
+				continue;
+		}
+
+		skb->protocol = eth_type_trans(skb, netdev);
+		skb->ip_summed = CHECKSUM_UNNECESSARY; /* don't check it */
+
+		napi_gro_receive(napi, skb);
+	}
+
+	rcu_read_unlock();
+
+	if (redirected)
+		xdp_do_flush();
+
+	if (work_done) {
+		stats = this_cpu_ptr(vif_ctx_lnx->stats);
+		u64_stats_update_begin(&stats->syncp);
+		stats->rx_packets += work_done;
+		stats->rx_bytes += rx_bytes;
+		stats->rx_multicast += rx_multicast;
+		stats->rx_xdp_drop += xdp_drop;
+		stats->rx_xdp_tx += xdp_tx;
+		stats->rx_xdp_redirect += xdp_redirect;
+		u64_stats_update_end(&stats->syncp);
+
+		nrf_wifi_rx_pools_sample(vif_ctx_lnx->rpu_ctx->rpu_ctx);
+	}
+
+	if (work_done < budget)
+		napi_complete_done(napi, work_done);
+
+	return work_done;
+}
+
+void nrf_wifi_netdev_stats_read(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx,
+				struct nrf_wifi_netdev_pcpu_stats *sum)
+{
+	struct nrf_wifi_netdev_pcpu_stats *stats = NULL;
+	struct nrf_wifi_netdev_pcpu_stats snap;
+	unsigned int start = 0;
+	int cpu = 0;
+
+	memset(sum, 0, sizeof(*sum));
+
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(vif_ctx_lnx->stats, cpu);
+
+		do {
+			start = u64_stats_fetch_begin_irq(&stats->syncp);
+			snap = *stats;
+		} while (u64_stats_fetch_retry_irq(&stats->syncp, start));
+
+		sum->rx_packets += snap.rx_packets;
+		sum->rx_bytes += snap.rx_bytes;
+		sum->rx_dropped += snap.rx_dropped;
+		sum->rx_multicast += snap.rx_multicast;
+		sum->rx_mc_filtered += snap.rx_mc_filtered;
+		sum->tx_packets += snap.tx_packets;
+		sum->tx_bytes += snap.tx_bytes;
+		sum->tx_dropped += snap.tx_dropped;
+		sum->tx_errors += snap.tx_errors;
+		sum->tx_fast_pkts += snap.tx_fast_pkts;
+		sum->tx_deferred_pkts += snap.tx_deferred_pkts;
+		sum->tx_queue_stops += snap.tx_queue_stops;
+		sum->tx_queue_wakes += snap.tx_queue_wakes;
+		sum->tx_credit_stalls += snap.tx_credit_stalls;
+		sum->tx_stopped_ns += snap.tx_stopped_ns;
+		sum->rx_xdp_drop += snap.rx_xdp_drop;
+		sum->rx_xdp_tx += snap.rx_xdp_tx;
+		sum->rx_xdp_redirect += snap.rx_xdp_redirect;
+	}
+}
+
+static void nrf_wifi_netdev_get_stats64(struct net_device *netdev,
+					struct rtnl_link_stats64 *stats)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+	struct nrf_wifi_netdev_pcpu_stats sum;
+
+	nrf_wifi_netdev_stats_read(vif_ctx_lnx, &sum);
+
+	stats->rx_packets = sum.rx_packets;
+	stats->rx_bytes = sum.rx_bytes;
+	stats->rx_dropped = sum.rx_dropped;
+	stats->multicast = sum.rx_multicast;
+	stats->tx_packets = sum.tx_packets;
+	stats->tx_bytes = sum.tx_bytes;
+	stats->tx_dropped = sum.tx_dropped;
+	stats->tx_errors = sum.tx_errors;
+}
+
+static void nrf_wifi_netdev_destructor(struct net_device *netdev)
+{
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = netdev_priv(netdev);
+
+	free_percpu(vif_ctx_lnx->stats);
+	vif_ctx_lnx->stats = NULL;
+}
+
+static void
+nrf_wifi_netdev_connect_done(struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx)
+{
+	unsigned int connect_us = 0;
+
+	if (!vif_ctx_lnx->connect_pending)
+		return;
+
+	vif_ctx_lnx->connect_pending = false;
+
+	connect_us = ktime_us_delta(ktime_get(), vif_ctx_lnx->connect_start);
+
+	if (!vif_ctx_lnx->connects ||
+	    connect_us < vif_ctx_lnx->connect_min_us)
+		vif_ctx_lnx->connect_min_us = connect_us;
+	vif_ctx_lnx->connect_max_us =
+		max(vif_ctx_lnx->connect_max_us, connect_us);
+	vif_ctx_lnx->connect_last_us = connect_us;
+	vif_ctx_lnx->connects++;
+	if (vif_ctx_lnx->connect_roam)
+		vif_ctx_lnx->roams++;
+	vif_ctx_lnx->connect_roam = false;
+
+	pr_debug("%s: Connected %u us after authentication started\n",
+		 __func__, connect_us);
 }
 
 enum nrf_wifi_status nrf_wifi_netdev_if_state_chg_callbk_fn(
@@ -269,11 +1389,18 @@ enum nrf_wifi_status nrf_wifi_netdev_if_state_chg_callbk_fn(
 	vif_ctx_lnx = (struct nrf_wifi_fmac_vif_ctx_lnx *)vif_ctx;
 	netdev = vif_ctx_lnx->netdev;
 
-	if (if_state == NRF_WIFI_FMAC_IF_CARR_STATE_ON)
+	if (if_state == NRF_WIFI_FMAC_IF_CARR_STATE_ON) {
+		nrf_wifi_cqm_reset(vif_ctx_lnx);
 		netif_carrier_on(netdev);
-	else if (if_state == NRF_WIFI_FMAC_IF_CARR_STATE_OFF)
+		nrf_wifi_netdev_connect_done(vif_ctx_lnx);
+	} else if (if_state == NRF_WIFI_FMAC_IF_CARR_STATE_OFF) {
 		netif_carrier_off(netdev);
-	else {
+		nrf_wifi_sta_cache_invalidate(vif_ctx_lnx);
+#ifdef CONFIG_NRF700X_DATA_TX
+		if (netif_running(netdev))
+			nrf_wifi_netdev_tx_flush(vif_ctx_lnx);
+#endif /* CONFIG_NRF700X_DATA_TX */
+	} else {
 		pr_err("%s: Invalid interface state %d\n", __func__, if_state);
 		goto out;
 	}
@@ -286,8 +1413,13 @@ out:
 const struct net_device_ops nrf_wifi_netdev_ops = {
 	.ndo_open = nrf_wifi_netdev_open,
 	.ndo_stop = nrf_wifi_netdev_close,
+	.ndo_get_stats64 = nrf_wifi_netdev_get_stats64,
+	.ndo_set_rx_mode = nrf_wifi_netdev_set_rx_mode,
+	.ndo_bpf = nrf_wifi_netdev_bpf,
 #ifdef CONFIG_NRF700X_DATA_TX
+	.ndo_select_queue = nrf_wifi_netdev_select_queue,
 	.ndo_start_xmit = nrf_wifi_netdev_start_xmit,
+	.ndo_xdp_xmit = nrf_wifi_netdev_xdp_xmit,
 #endif /* CONFIG_NRF700X_DATA_TX */
 };
 
@@ -298,12 +1430,12 @@ nrf_wifi_netdev_add_vif(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx,
 {
 	struct net_device *netdev = NULL;
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
-	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
 	int ret = 0;
 
 	ASSERT_RTNL();
 
-	netdev = alloc_etherdev(sizeof(struct nrf_wifi_fmac_vif_ctx_lnx));
+	netdev = alloc_etherdev_mq(sizeof(struct nrf_wifi_fmac_vif_ctx_lnx),
+				   NL80211_NUM_ACS);
 
 	if (!netdev) {
 		pr_err("%s: Unable to allocate memory for a new netdev\n",
@@ -314,7 +1446,6 @@ nrf_wifi_netdev_add_vif(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx,
 	vif_ctx_lnx = netdev_priv(netdev);
 	vif_ctx_lnx->rpu_ctx = rpu_ctx_lnx;
 	vif_ctx_lnx->netdev = netdev;
-	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
 
 	netdev->netdev_ops = &nrf_wifi_netdev_ops;
 
@@ -325,17 +1456,67 @@ nrf_wifi_netdev_add_vif(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx,
 	netdev->ieee80211_ptr = wdev;
 
 	netdev->needed_headroom = TX_BUF_HEADROOM;
+	netdev->ethtool_ops = &nrf_wifi_ethtool_ops;
+
+#ifdef CONFIG_NRF700X_TCP_IP_CHECKSUM_OFFLOAD
+	/* Toggled at runtime through ethtool -K */
+	netdev->hw_features |= NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM;
+	netdev->features |= netdev->hw_features;
+#endif /* CONFIG_NRF700X_TCP_IP_CHECKSUM_OFFLOAD */
+
+	vif_ctx_lnx->stats =
+		netdev_alloc_pcpu_stats(struct nrf_wifi_netdev_pcpu_stats);
+	if (!vif_ctx_lnx->stats) {
+		pr_err("%s: Unable to allocate netdev stats\n", __func__);
+		free_netdev(netdev);
+		vif_ctx_lnx = NULL;
+		goto out;
+	}
 
-	netdev->priv_destructor = free_netdev;
+	/* register_netdevice() also runs the destructor when it fails */
+	netdev->needs_free_netdev = true;
+	netdev->priv_destructor = nrf_wifi_netdev_destructor;
+
+	nrf_wifi_vif_cmd_init(vif_ctx_lnx);
+	nrf_wifi_sched_scan_init(vif_ctx_lnx);
+	nrf_wifi_bss_init(vif_ctx_lnx);
+	nrf_wifi_cqm_init(vif_ctx_lnx);
+	skb_queue_head_init(&vif_ctx_lnx->rx_napi_q);
+	spin_lock_init(&vif_ctx_lnx->mc_lock);
+	INIT_LIST_HEAD(&vif_ctx_lnx->mc_cmds);
+	INIT_WORK(&vif_ctx_lnx->ws_rx_mode, nrf_wifi_netdev_rx_mode_work);
+	netif_napi_add(netdev, &vif_ctx_lnx->napi, nrf_wifi_netdev_poll,
+		       NAPI_POLL_WEIGHT);
+
+	ret = xdp_rxq_info_reg(&vif_ctx_lnx->xdp_rxq, netdev, 0,
+			       vif_ctx_lnx->napi.napi_id);
+	if (!ret)
+		ret = xdp_rxq_info_reg_mem_model(&vif_ctx_lnx->xdp_rxq,
+						 MEM_TYPE_PAGE_SHARED, NULL);
+	if (ret) {
+		pr_err("%s: Unable to register XDP RX queue, ret=%d\n",
+		       __func__, ret);
+		goto err_reg_netdev;
+	}
 #ifdef CONFIG_NRF700X_DATA_TX
-	vif_ctx_lnx->data_txq =
-		nrf_wifi_utils_q_alloc(fmac_dev_ctx->fpriv->opriv);
-	if (vif_ctx_lnx->data_txq == NULL) {
+	vif_ctx_lnx->tx_wq = alloc_workqueue("nrf_wifi_tx_%s", WQ_HIGHPRI, 0,
+					     if_name);
+	if (!vif_ctx_lnx->tx_wq) {
+		pr_err("%s: Unable to allocate TX workqueue\n", __func__);
+		ret = -ENOMEM;
+		goto err_reg_netdev;
+	}
+
+	ret = nrf_wifi_netdev_fq_init(vif_ctx_lnx);
+	if (ret) {
+		pr_err("%s: Unable to allocate TX fair queue\n", __func__);
 		goto err_reg_netdev;
 	}
+
+	vif_ctx_lnx->tx_qlen = CONFIG_NRF700X_MAX_TX_PENDING_QLEN;
+	vif_ctx_lnx->tx_budget = READ_ONCE(tx_budget);
+	vif_ctx_lnx->tx_credit_depth = max_tx_aggregation;
 	INIT_WORK(&vif_ctx_lnx->ws_data_tx, nrf_cfg80211_data_tx_routine);
-	INIT_WORK(&vif_ctx_lnx->ws_queue_monitor,
-		  nrf_cfg80211_queue_monitor_routine);
 #endif
 	ret = register_netdevice(netdev);
 
@@ -347,6 +1528,15 @@ nrf_wifi_netdev_add_vif(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx,
 
 err_reg_netdev:
 	if (ret) {
+#ifdef CONFIG_NRF700X_DATA_TX
+		if (vif_ctx_lnx->tx_cvars)
+			nrf_wifi_netdev_fq_deinit(vif_ctx_lnx);
+		if (vif_ctx_lnx->tx_wq)
+			destroy_workqueue(vif_ctx_lnx->tx_wq);
+#endif /* CONFIG_NRF700X_DATA_TX */
+		if (xdp_rxq_info_is_reg(&vif_ctx_lnx->xdp_rxq))
+			xdp_rxq_info_unreg(&vif_ctx_lnx->xdp_rxq);
+		free_percpu(vif_ctx_lnx->stats);
 		free_netdev(netdev);
 		netdev = NULL;
 		vif_ctx_lnx = NULL;
@@ -358,17 +1548,25 @@ out:
 void nrf_wifi_netdev_del_vif(struct net_device *netdev)
 {
 	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
-	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
-	struct nrf_wifi_fmac_dev_ctx *fmac_dev_ctx = NULL;
+	struct nrf_wifi_netdev_mc_cmd *cmd = NULL;
+	struct nrf_wifi_netdev_mc_cmd *tmp = NULL;
 
 	vif_ctx_lnx = netdev_priv(netdev);
-	rpu_ctx_lnx = vif_ctx_lnx->rpu_ctx;
-	fmac_dev_ctx = rpu_ctx_lnx->rpu_ctx;
-
-	nrf_wifi_utils_q_free(fmac_dev_ctx->fpriv->opriv,
-			      vif_ctx_lnx->data_txq);
 
 	unregister_netdevice(netdev);
 	netdev->ieee80211_ptr = NULL;
+	xdp_rxq_info_unreg(&vif_ctx_lnx->xdp_rxq);
+	netif_napi_del(&vif_ctx_lnx->napi);
+
+	cancel_work_sync(&vif_ctx_lnx->ws_rx_mode);
+	nrf_wifi_sched_scan_deinit(vif_ctx_lnx);
+	list_for_each_entry_safe(cmd, tmp, &vif_ctx_lnx->mc_cmds, list) {
+		list_del(&cmd->list);
+		kfree(cmd);
+	}
+#ifdef CONFIG_NRF700X_DATA_TX
+	destroy_workqueue(vif_ctx_lnx->tx_wq);
+	nrf_wifi_netdev_fq_deinit(vif_ctx_lnx);
+#endif /* CONFIG_NRF700X_DATA_TX */
 }
 #endif /* !CONFIG_NRF700X_RADIO_TEST */
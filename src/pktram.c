@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+#ifndef CONFIG_NRF700X_RADIO_TEST
+#include <linux/netdevice.h>
+#include <linux/workqueue.h>
+
+#include "main.h"
+#include "fmac_main.h"
+#include "net_stack.h"
+
+extern unsigned int pktram_policy;
+extern unsigned int pktram_rx_heavy_pct;
+extern unsigned int pktram_tx_heavy_pct;
+extern unsigned int pktram_hold;
+
+#define NRF_WIFI_PKTRAM_INTERVAL_MS 1000
+/* Intervals carrying less than this do not count towards a direction */
+#define NRF_WIFI_PKTRAM_BUSY_BYTES (64 * 1024)
+/* Bytes one direction has to carry for each byte of the other one */
+#define NRF_WIFI_PKTRAM_DIR_RATIO 2
+/* PKTRAM left to the TX tokens has to hold at least one frame per token */
+#define NRF_WIFI_PKTRAM_RX_MAX                                                 \
+	(RPU_PKTRAM_SIZE -                                                     \
+	 (CONFIG_NRF700X_MAX_TX_TOKENS *                                       \
+	  (CONFIG_NRF700X_TX_MAX_DATA_SIZE + MAX_PKT_RAM_TX_ALIGN_OVERHEAD)))
+
+unsigned int nrf_wifi_rx_pools_size(const struct rx_buf_pool_params *pools)
+{
+	unsigned int size = 0;
+	int i = 0;
+
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++)
+		size += pools[i].num_bufs * pools[i].buf_sz;
+
+	return size;
+}
+
+/* Spread evenly over the pools, keeping their buffer sizes */
+static void nrf_wifi_pktram_spread(struct rx_buf_pool_params *pools,
+				   unsigned int num_bufs)
+{
+	int i = 0;
+
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++) {
+		pools[i].num_bufs = num_bufs / MAX_NUM_OF_RX_QUEUES;
+		if (i < num_bufs % MAX_NUM_OF_RX_QUEUES)
+			pools[i].num_bufs++;
+	}
+}
+
+static enum nrf_wifi_pktram_dir nrf_wifi_pktram_dir(u64 rx_bytes,
+						    u64 tx_bytes)
+{
+	if (rx_bytes >= NRF_WIFI_PKTRAM_DIR_RATIO * tx_bytes)
+		return NRF_WIFI_PKTRAM_DIR_RX;
+
+	if (tx_bytes >= NRF_WIFI_PKTRAM_DIR_RATIO * rx_bytes)
+		return NRF_WIFI_PKTRAM_DIR_TX;
+
+	return NRF_WIFI_PKTRAM_DIR_NONE;
+}
+
+/* Direction the split should favour, NONE leaves the RX pools alone */
+enum nrf_wifi_pktram_dir
+nrf_wifi_pktram_target_dir(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
+{
+	struct nrf_wifi_pktram *pktram = &rpu_ctx_lnx->pktram;
+
+	switch (READ_ONCE(pktram_policy)) {
+	case NRF_WIFI_PKTRAM_POLICY_RX:
+		return NRF_WIFI_PKTRAM_DIR_RX;
+	case NRF_WIFI_PKTRAM_POLICY_TX:
+		return NRF_WIFI_PKTRAM_DIR_TX;
+	case NRF_WIFI_PKTRAM_POLICY_AUTO:
+		if (pktram->hold >= READ_ONCE(pktram_hold))
+			return pktram->dir;
+		return NRF_WIFI_PKTRAM_DIR_NONE;
+	default:
+		return NRF_WIFI_PKTRAM_DIR_NONE;
+	}
+}
+
+/* RX pools giving the RX buffers their share of the PKTRAM for @dir */
+bool nrf_wifi_pktram_target(enum nrf_wifi_pktram_dir dir,
+			    struct rx_buf_pool_params *pools)
+{
+	unsigned int num_bufs = 0;
+	unsigned int buf_sz = 0;
+	unsigned int pct = 0;
+	int i = 0;
+
+	if (dir == NRF_WIFI_PKTRAM_DIR_NONE)
+		return false;
+
+	if (dir == NRF_WIFI_PKTRAM_DIR_RX)
+		pct = READ_ONCE(pktram_rx_heavy_pct);
+	else
+		pct = READ_ONCE(pktram_tx_heavy_pct);
+
+	nrf_wifi_rx_pools_get(pools);
+
+	for (i = 0; i < MAX_NUM_OF_RX_QUEUES; i++)
+		buf_sz = max(buf_sz, pools[i].buf_sz);
+
+	if (!buf_sz)
+		return false;
+
+	num_bufs = RPU_PKTRAM_SIZE / 100 * min(pct, 100U) / buf_sz;
+	num_bufs = min(num_bufs, NRF_WIFI_PKTRAM_RX_MAX / buf_sz);
+	num_bufs = max_t(unsigned int, num_bufs, MAX_NUM_OF_RX_QUEUES);
+
+	nrf_wifi_pktram_spread(pools, num_bufs);
+
+	return true;
+}
+
+static void nrf_wifi_pktram_work(struct work_struct *work)
+{
+	struct nrf_wifi_pktram *pktram = NULL;
+	struct nrf_wifi_ctx_lnx *rpu_ctx_lnx = NULL;
+	struct nrf_wifi_fmac_vif_ctx_lnx *vif_ctx_lnx = NULL;
+	struct rx_buf_pool_params target[MAX_NUM_OF_RX_QUEUES];
+	struct rx_buf_pool_params pools[MAX_NUM_OF_RX_QUEUES];
+	struct nrf_wifi_netdev_pcpu_stats sum;
+	enum nrf_wifi_pktram_dir dir = NRF_WIFI_PKTRAM_DIR_NONE;
+	bool pending = false;
+	u64 rx_bytes = 0;
+	u64 tx_bytes = 0;
+
+	pktram = container_of(to_delayed_work(work), struct nrf_wifi_pktram,
+			      ws);
+	rpu_ctx_lnx = container_of(pktram, struct nrf_wifi_ctx_lnx, pktram);
+	vif_ctx_lnx = rpu_ctx_lnx->def_vif_ctx;
+
+	nrf_wifi_netdev_stats_read(vif_ctx_lnx, &sum);
+	rx_bytes = sum.rx_bytes - pktram->rx_bytes;
+	tx_bytes = sum.tx_bytes - pktram->tx_bytes;
+	pktram->rx_bytes = sum.rx_bytes;
+	pktram->tx_bytes = sum.tx_bytes;
+
+	/* Idle intervals keep what was learnt, e.g. while the link is down */
+	if (rx_bytes + tx_bytes >= NRF_WIFI_PKTRAM_BUSY_BYTES) {
+		dir = nrf_wifi_pktram_dir(rx_bytes, tx_bytes);
+
+		if (dir != pktram->dir) {
+			pktram->dir = dir;
+			pktram->hold = 0;
+		}
+
+		if (pktram->hold < UINT_MAX)
+			pktram->hold++;
+	}
+
+	/* The RPU takes the RX pools when the firmware boots, a new split
+	 * is only recommended (see the debugfs pktram file) and takes a
+	 * reload with the target pools
+	 */
+	dir = nrf_wifi_pktram_target_dir(rpu_ctx_lnx);
+	if (nrf_wifi_pktram_target(dir, target)) {
+		nrf_wifi_rx_pools_get(pools);
+		pending = memcmp(target, pools, sizeof(pools));
+	}
+
+	pktram->pending = pending;
+
+	nrf_wifi_pktram_start(rpu_ctx_lnx);
+}
+
+void nrf_wifi_pktram_init(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
+{
+	INIT_DELAYED_WORK(&rpu_ctx_lnx->pktram.ws, nrf_wifi_pktram_work);
+}
+
+void nrf_wifi_pktram_start(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
+{
+	/* The static policy never recommends anything */
+	if (READ_ONCE(pktram_policy) == NRF_WIFI_PKTRAM_POLICY_STATIC ||
+	    READ_ONCE(pktram_policy) >= NRF_WIFI_PKTRAM_POLICY_MAX)
+		return;
+
+	schedule_delayed_work(&rpu_ctx_lnx->pktram.ws,
+			      msecs_to_jiffies(NRF_WIFI_PKTRAM_INTERVAL_MS));
+}
+
+void nrf_wifi_pktram_stop(struct nrf_wifi_ctx_lnx *rpu_ctx_lnx)
+{
+	cancel_delayed_work_sync(&rpu_ctx_lnx->pktram.ws);
+}
+#endif /* !CONFIG_NRF700X_RADIO_TEST */
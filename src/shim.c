@@ -20,6 +20,7 @@
 #include <linux/spi/spi.h>
 #include <linux/pci.h>
 #include <linux/netdevice.h>
+#include <linux/bpf.h>
 #include <linux/bug.h>
 #include <linux/irq.h>
 #include <net/cfg80211.h>
@@ -31,6 +32,7 @@
 #include "fmac_api.h"
 #include "main.h"
 #include "shim.h"
+#include "net_stack.h"
 #include "pal.h"
 #include "rpu_hw_if.h"
 #include "spi_if.h"
@@ -272,8 +274,28 @@ static int shim_pr_err(const char *fmt, va_list args)
 static void *shim_nbuf_alloc(unsigned int size)
 {
 	struct sk_buff *nbuf = NULL;
+	unsigned int frag_size = 0;
+	void *data = NULL;
+
+	/* Page fragment backed with XDP headroom, so that XDP programs can
+	 * run on RX frames in place (see nrf_wifi_netdev_xdp_rx()).
+	 */
+	frag_size = SKB_DATA_ALIGN(XDP_PACKET_HEADROOM + size) +
+		    SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	if (frag_size <= PAGE_SIZE)
+		data = netdev_alloc_frag(frag_size);
+
+	if (data) {
+		nbuf = build_skb(data, frag_size);
+		if (nbuf)
+			skb_reserve(nbuf, XDP_PACKET_HEADROOM);
+		else
+			skb_free_frag(data);
+	}
 
-	nbuf = alloc_skb(size, GFP_ATOMIC);
+	if (!nbuf)
+		nbuf = alloc_skb(size, GFP_ATOMIC);
 
 	if (!nbuf)
 		pr_err("%s: Unable to allocate memory for network buffer\n",
@@ -284,6 +306,12 @@ static void *shim_nbuf_alloc(unsigned int size)
 
 static void shim_nbuf_free(void *nbuf)
 {
+#ifdef CONFIG_NRF700X_DATA_TX
+	/* Data frames are freed by the FMAC on TX done */
+	if (nrf_wifi_netdev_tx_done(nbuf))
+		return;
+#endif /* CONFIG_NRF700X_DATA_TX */
+
 	kfree_skb(nbuf);
 }
 
@@ -1046,6 +1074,8 @@ static void shim_bus_spi_deinit(void *os_spi_priv)
 
 	lnx_spi_priv = os_spi_priv;
 
+	/* The SPI driver is registered from a work, it may still be pending */
+	flush_work(&lnx_spi_priv->drv_reg);
 	spi_unregister_driver(lnx_spi_priv->spi_drv);
 
 	kfree(lnx_spi_priv->spi_drv);